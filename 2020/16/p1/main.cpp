@@ -22,15 +22,13 @@ namespace
 
     uint scanningErrorRate(const Notes &notes)
     {
+        const auto valid = validValues(notes.rules);
         return sum(ranges::views::transform(notes.tickets
                 | ranges::views::drop(1),
-            [&notes](const auto &ticket){
+            [&valid](const auto &ticket){
                 return sum(ticket
-                    | ranges::views::filter([&notes](auto v){
-                            return !ranges::any_of(notes.rules,
-                                [v](const auto &rule){
-                                    return matchesRule(rule, v);
-                                });
+                    | ranges::views::filter([&valid](auto v){
+                            return !valid.contains(v);
                         }));
             }));
     }
@@ -17,14 +17,11 @@ namespace
 
     using Cand = vector<unordered_set<size_t>>;
 
-    bool validTicket(const vector<Rule> &rules, const ValCol &ticket)
+    bool validTicket(const RangeSet &valid, const ValCol &ticket)
     {
-        return !ranges::any_of(ticket, [&rules](auto v){
-                return !ranges::any_of(rules,
-                    [v](const auto &rule){
-                        return matchesRule(rule, v);
-                    });
-                });
+        return ranges::all_of(ticket, [&valid](auto v){
+                return valid.contains(v);
+            });
     }
 
     Cand invertCand(const Cand &cands)
@@ -66,9 +63,10 @@ namespace
 
     optional<vector<string>> findFields(const Notes &notes)
     {
+        const auto valid = validValues(notes.rules);
         auto validTickets = notes.tickets | ranges::views::filter(
-            [&notes](const auto &ticket){
-                    return validTicket(notes.rules, ticket);
+            [&valid](const auto &ticket){
+                    return validTicket(valid, ticket);
                 });
         vector<unordered_set<size_t>> candidates;
         {
@@ -6,13 +6,13 @@
 #include <optional>
 #include <string_view>
 #include <regex>
-#include <array>
 #include <vector>
 #include <ranges>
 #include <iterator>
 #include <utility>
 
 #include "../base.hpp"
+#include "../../2023/interval_set.hpp"
 
 namespace task
 {
@@ -22,16 +22,13 @@ namespace task
     using ulint = unsigned long long int;
     using ValCol = vector<uint>;
 
-    struct Range
-    {
-        uint start;
-        uint len;
-    };
+    using Range = xutil::Interval<uint>;
+    using RangeSet = xutil::IntervalSet<uint>;
 
     struct Rule
     {
         string name;
-        array<Range, 2> ranges;
+        RangeSet ranges;
     };
 
     struct Notes
@@ -52,7 +49,7 @@ namespace task
             {
                 return {};
             }
-            return Range{*startRes, *endRes-*startRes+1};
+            return Range{*startRes, *endRes+1};
         }
 
         inline optional<Rule> parseRule(const string &rule)
@@ -72,7 +69,7 @@ namespace task
             {
                 return {};
             }
-            return Rule{matches.str(1), {*fstRangeRes, *sndRangeRes}};
+            return Rule{matches.str(1), RangeSet{*fstRangeRes, *sndRangeRes}};
         }
 
         optional<ValCol> parseValues(string_view values)
@@ -91,11 +88,6 @@ namespace task
             }
             return result;
         }
-
-        constexpr bool inrange(const Range &range, uint val)
-        {
-            return val >= range.start && val < range.start+range.len;
-        }
     }
 
     inline optional<Notes> parseNotes(
@@ -141,9 +133,19 @@ namespace task
         return Notes{move(rules), move(tickets)};
     }
 
-    constexpr bool matchesRule(const Rule &rule, uint val)
+    inline bool matchesRule(const Rule &rule, uint val)
     {
-        return inrange(rule.ranges[0], val) || inrange(rule.ranges[1], val);
+        return rule.ranges.contains(val);
+    }
+
+    inline RangeSet validValues(const vector<Rule> &rules)
+    {
+        RangeSet result;
+        for(const auto &rule : rules)
+        {
+            result = result | rule.ranges;
+        }
+        return result;
     }
 }
 
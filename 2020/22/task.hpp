@@ -11,11 +11,10 @@
 #include <iterator>
 #include <deque>
 #include <array>
-#include <unordered_set>
-#include <sstream>
 #include <type_traits>
 
 #include "../base.hpp"
+#include "../../2023/cycle.hpp"
 
 namespace task
 {
@@ -43,22 +42,14 @@ namespace task
             return result;
         }
 
-        template<typename T>
-            requires base::MatchRefTuple<T, HandCol>::value &&
-                (tuple_size_v<T> == 2)
-        string describe(const T &hands)
+        inline xutil::QueueHash handHash(const HandCol &hand)
         {
-            stringstream result;
-            auto append = [&result](const HandCol &hand){
-                for(auto v : hand)
-                {
-                    result<<v<<',';
-                }
-            };
-            append(get<0>(hands));
-            result<<'|';
-            append(get<1>(hands));
-            return move(result).str();
+            xutil::QueueHash result;
+            for(auto v : hand)
+            {
+                result.push(v);
+            }
+            return result;
         }
 
         template<bool recurse, typename T>
@@ -67,14 +58,19 @@ namespace task
         Win play(const T &hands)
         {
             const auto &[hand1, hand2] = hands;
-            unordered_set<string> seen;
+            auto hash1 = handHash(hand1);
+            auto hash2 = handHash(hand2);
+            xutil::CycleDetector seen;
             while(!hand1.empty() && !hand2.empty())
             {
                 const auto c1 = hand1.front();
                 const auto c2 = hand2.front();
                 hand1.pop_front();
                 hand2.pop_front();
-                if(!seen.insert(describe(hands)).second)
+                hash1.pop(c1);
+                hash2.pop(c2);
+                if(seen.observe(
+                        xutil::hashCombine(hash1.value(), hash2.value())))
                 {
                     return Win::PLAYER1;
                 }
@@ -93,10 +89,14 @@ namespace task
                 if(fstWin)
                 {
                     ranges::copy(to_array({c1, c2}), back_inserter(hand1));
+                    hash1.push(c1);
+                    hash1.push(c2);
                 }
                 else
                 {
                     ranges::copy(to_array({c2, c1}), back_inserter(hand2));
+                    hash2.push(c2);
+                    hash2.push(c1);
                 }
             }
             return !hand1.empty()?Win::PLAYER1:Win::PLAYER2;
@@ -1,33 +1,25 @@
 #include <iostream>
+#include <cassert>
 
 #include "../../base.hpp"
+#include "../../../2023/intmath.hpp"
 
 using namespace std;
 
 namespace
 {
-    using uint = unsigned int;
     using ulint = unsigned long long int;
 
-
-    uint findLoopSize(ulint mod, ulint subject, ulint result)
+    ulint findLoopSize(ulint mod, ulint subject, ulint result)
     {
-        uint i = 0;
-        for(ulint v = 1; v != result; ++i)
-        {
-            v = (v*subject)%mod;
-        }
-        return i;
+        const auto loopSize = numutil::discreteLog(subject, result, mod);
+        assert(loopSize);
+        return *loopSize;
     }
 
-    ulint transform(ulint mod, ulint subject, uint loopSize)
+    ulint transform(ulint mod, ulint subject, ulint loopSize)
     {
-        ulint v = 1;
-        for(uint i = 0; i < loopSize; ++i)
-        {
-            v = (v*subject)%mod;
-        }
-        return v;
+        return numutil::powmod(subject, loopSize, mod);
     }
 }
 
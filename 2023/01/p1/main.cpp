@@ -1,17 +1,11 @@
-#include <algorithm>
-#include <functional>
 #include <iostream>
-#include <ranges>
-#include <string>
 
+#include "../../mapped_input.hpp"
 #include "../task.hpp"
 
 int main()
 {
-    std::cout << std::ranges::fold_left(
-                     std::ranges::istream_view<std::string>(std::cin) |
-                         std::views::transform(task::extractCalibrationValue),
-                     0LL, std::plus<>{})
-              << '\n';
+    const xutil::MappedInput input;
+    std::cout << task::sumCalibrationValues<false>(input.view()) << '\n';
     return 0;
 }
@@ -1,40 +1,112 @@
 #ifndef TASK_HPP
 #define TASK_HPP
 
-#include <cctype>
-#include <optional>
-#include <string>
+#include <array>
+#include <cstddef>
 #include <string_view>
 
-#include "../base.hpp"
+#include "../mapped_input.hpp"
+#include "../parallel.hpp"
 
 namespace task
 {
 using uval = unsigned int;
 using ulval = unsigned long long int;
 
-inline uval extractCalibrationValue(std::string_view line)
+namespace detail
 {
-    std::optional<char> firstDigit;
-    char lastDigit = '0';
-    for(const auto v : line)
+    constexpr uval NO_DIGIT = 10;
+
+    struct SpelledDigit
     {
-        if(std::isdigit(v))
+        std::string_view name;
+        uval value{NO_DIGIT};
+    };
+
+    // The spelled-out digits sharing a first letter, at most two of them.
+    using Candidates = std::array<SpelledDigit, 2>;
+
+    constexpr auto SPELLED_DIGITS = [] {
+        constexpr std::array<std::string_view, 9> NAMES{
+            "one", "two", "three", "four", "five",
+            "six", "seven", "eight", "nine",
+        };
+        std::array<Candidates, 26> table{};
+        for(std::size_t i = 0; i < NAMES.size(); ++i)
         {
-            if(!firstDigit)
+            auto &candidates = table[NAMES[i].front() - 'a'];
+            auto &slot = candidates[candidates[0].value == NO_DIGIT ? 0 : 1];
+            slot = {NAMES[i], static_cast<uval>(i + 1)};
+        }
+        return table;
+    }();
+
+    template<bool Amended>
+    constexpr uval digitAt(const std::string_view line, const std::size_t pos)
+    {
+        const auto v = line[pos];
+        if(v >= '0' && v <= '9')
+        {
+            return static_cast<uval>(v - '0');
+        }
+        if constexpr(Amended)
+        {
+            if(v >= 'a' && v <= 'z')
             {
-                firstDigit = v;
+                for(const auto &candidate : SPELLED_DIGITS[v - 'a'])
+                {
+                    if(candidate.value != NO_DIGIT &&
+                       line.substr(pos).starts_with(candidate.name))
+                    {
+                        return candidate.value;
+                    }
+                }
             }
-            lastDigit = v;
         }
+        return NO_DIGIT;
     }
-    std::string digits;
-    if(firstDigit)
+}
+
+// The amended value also counts digits spelled out with letters, the first
+// and the last one are searched for from the respective end of the line.
+template<bool Amended = false>
+constexpr uval extractCalibrationValue(const std::string_view line)
+{
+    std::size_t front = 0;
+    auto first = detail::NO_DIGIT;
+    for(; front < line.size() && first == detail::NO_DIGIT; ++front)
+    {
+        first = detail::digitAt<Amended>(line, front);
+    }
+    if(first == detail::NO_DIGIT)
+    {
+        return 0;
+    }
+    auto last = detail::NO_DIGIT;
+    for(auto back = line.size(); back >= front && last == detail::NO_DIGIT;
+        --back)
     {
-        digits.push_back(*firstDigit);
+        last = detail::digitAt<Amended>(line, back - 1);
     }
-    digits.push_back(lastDigit);
-    return *base::parseValue<uval>(digits);
+    return first * 10 + last;
+}
+
+template<bool Amended = false>
+ulval sumCalibrationValues(const std::string_view input)
+{
+    const auto chunks = xutil::splitChunks(input, xutil::workerCount());
+    return xutil::parallelReduce(
+        chunks.size(), ulval{},
+        [&](const std::size_t begin, const std::size_t end) {
+            ulval sum = 0;
+            for(auto idx = begin; idx < end; ++idx)
+            {
+                xutil::forEachLine(chunks[idx], [&](const auto line) {
+                    sum += extractCalibrationValue<Amended>(line);
+                });
+            }
+            return sum;
+        });
 }
 }
 
@@ -1,59 +1,35 @@
 #include <algorithm>
 #include <format>
+#include <functional>
 #include <iostream>
-#include <iterator>
-#include <ranges>
 #include <stdexcept>
 #include <string>
-#include <tuple>
 
+#include "../../mapped_input.hpp"
 #include "../task.hpp"
 
 namespace
 {
-const task::CubeCounts CUBE_LIMITS{
-    {"red", 12},
-    {"green", 13},
-    {"blue", 14},
-};
+constexpr task::ColorCounts CUBE_LIMITS{12, 13, 14};
 
-bool checkGame(const task::Game &game)
+bool checkGame(const task::GameSummary &game)
 {
-    return std::ranges::all_of(game, [](const auto &counts) {
-        return std::ranges::all_of(counts, [](const auto &cubeCount) {
-            if(const auto iter = CUBE_LIMITS.find(std::get<0>(cubeCount));
-               iter != end(CUBE_LIMITS))
-            {
-                return std::get<1>(cubeCount) <= iter->second;
-            }
-            return false;
-        });
-    });
+    return std::ranges::equal(game.maxima, CUBE_LIMITS, std::less_equal<>{});
 }
 }
 
 int main()
 {
-    task::ulval result = 0;
-    while(std::cin)
+    const xutil::MappedInput input;
+    const auto maybeResult =
+        task::sumGames(input.view(), [](const auto &game) -> task::ulval {
+            return checkGame(game) ? game.id : 0;
+        });
+    if(!maybeResult)
     {
-        std::string str;
-        std::getline(std::cin, str);
-        if(str.empty())
-        {
-            continue;
-        }
-        const auto maybeGame = task::parseGame(str);
-        if(!maybeGame)
-        {
-            throw std::invalid_argument(
-                std::format("invalid input: {}", maybeGame.error()));
-        }
-        if(checkGame(std::get<1>(*maybeGame)))
-        {
-            result += std::get<0>(*maybeGame);
-        }
+        throw std::invalid_argument(
+            std::format("invalid input: {}", maybeResult.error()));
     }
-    std::cout << result << '\n';
+    std::cout << *maybeResult << '\n';
     return 0;
 }
@@ -1,65 +1,37 @@
-#include <algorithm>
+#include <cstddef>
 #include <format>
-#include <functional>
 #include <iostream>
-#include <iterator>
 #include <stdexcept>
 #include <string>
-#include <tuple>
-#include <unordered_map>
 
+#include "../../mapped_input.hpp"
 #include "../task.hpp"
 
 namespace
 {
-auto minCubes(const task::Game &game)
+task::ulval cubesPower(const task::GameSummary &game)
 {
-    task::CubeCounts cubeCounts;
-    for(const auto &round : game)
+    task::ulval result = 1;
+    for(std::size_t i = 0; i < task::COLOR_COUNT; ++i)
     {
-        for(const auto &[color, count] : round)
+        if(game.shown(static_cast<task::Color>(i)))
         {
-            auto &cur = cubeCounts[color];
-            cur = std::max(cur, count);
+            result *= game.maxima[i];
         }
     }
-    return cubeCounts;
-}
-
-auto cubesPower(const task::CubeCounts &cubeCounts)
-{
-    return std::ranges::fold_left(
-        cubeCounts |
-            std::views::transform([](const auto &cnt) { return cnt.second; }),
-        static_cast<task::ulval>(1), std::multiplies<>{});
+    return result;
 }
 }
 
 int main()
 {
-    task::ulval result = 0;
-    for(const auto &line :
-        std::ranges::subrange(std::istreambuf_iterator<char>{std::cin},
-                              std::istreambuf_iterator<char>{}) |
-            std::views::lazy_split('\n') |
-            std::views::transform([](auto lineView) {
-                std::string line;
-                std::ranges::copy(lineView, std::back_inserter(line));
-                return line;
-            }))
+    const xutil::MappedInput input;
+    const auto maybeResult = task::sumGames(input.view(), cubesPower);
+    if(!maybeResult)
     {
-        if(line.empty())
-        {
-            continue;
-        }
-        const auto maybeGame = task::parseGame(line);
-        if(!maybeGame)
-        {
-            throw std::invalid_argument(
-                std::format("invalid input: {}", maybeGame.error()));
-        }
-        result += cubesPower(minCubes(std::get<1>(*maybeGame)));
+        throw std::invalid_argument(
+            std::format("invalid input: {}", maybeResult.error()));
     }
-    std::cout << result << '\n';
+    std::cout << *maybeResult << '\n';
     return 0;
 }
@@ -1,17 +1,27 @@
 #ifndef TASK_HPP
 #define TASK_HPP
 
+#include <array>
 #include <cassert>
+#include <cstddef>
+#include <cstdint>
 #include <expected>
+#include <format>
+#include <limits>
+#include <optional>
 #include <ranges>
 #include <regex>
 #include <string>
+#include <string_view>
 #include <tuple>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 
 #include "../base.hpp"
+#include "../mapped_input.hpp"
+#include "../parallel.hpp"
+#include "../parse_stream.hpp"
 
 namespace task
 {
@@ -58,6 +68,229 @@ std::expected<std::tuple<GameID, Game>, std::string> parseGame(const auto &game)
     }
     return std::unexpected("invalid game");
 }
+
+enum class Color : std::uint8_t
+{
+    RED,
+    GREEN,
+    BLUE,
+};
+
+constexpr std::size_t COLOR_COUNT = 3;
+constexpr std::array<std::string_view, COLOR_COUNT> COLOR_NAMES{
+    "red",
+    "green",
+    "blue",
+};
+
+using ColorCounts = std::array<Count, COLOR_COUNT>;
+
+// The largest count of every colour shown in any round of a game.
+struct GameSummary
+{
+    GameID id{};
+    ColorCounts maxima{};
+    std::uint8_t shownColors{};
+
+    [[nodiscard]] bool shown(const Color color) const
+    {
+        return (shownColors >> static_cast<unsigned>(color)) & 1U;
+    }
+};
+
+namespace detail
+{
+    template<typename T>
+    using ParseResult = std::expected<T, parser::ParseError>;
+    using ErrorCode = parser::ParseErrorCode;
+
+    inline ParseResult<void> parseLiteral(parser::ParseStream &stream,
+                                          const std::string_view literal,
+                                          const char *context)
+    {
+        for(const auto expected : literal)
+        {
+            const auto maybeVal = stream.read();
+            if(maybeVal != expected)
+            {
+                return stream.fail(maybeVal ? ErrorCode::UNEXPECTED_CHARACTER
+                                            : ErrorCode::UNEXPECTED_END,
+                                   context);
+            }
+        }
+        return {};
+    }
+
+    inline void skipSpaces(parser::ParseStream &stream)
+    {
+        while(stream.peek() == ' ')
+        {
+            stream.read();
+        }
+    }
+
+    inline ParseResult<Count> parseCount(parser::ParseStream &stream,
+                                         const char *context)
+    {
+        Count result = 0;
+        std::size_t digits = 0;
+        while(const auto maybeVal = stream.peek())
+        {
+            if(*maybeVal < '0' || *maybeVal > '9')
+            {
+                break;
+            }
+            const auto digit = static_cast<Count>(*maybeVal - '0');
+            if(result > (std::numeric_limits<Count>::max() - digit) / 10)
+            {
+                return stream.fail(ErrorCode::INVALID_VALUE, context);
+            }
+            result = result * 10 + digit;
+            ++digits;
+            stream.read();
+        }
+        if(digits == 0)
+        {
+            return stream.fail(ErrorCode::EMPTY_TOKEN, context);
+        }
+        return result;
+    }
+
+    // Dispatches on the first letter, the colour names differ in it.
+    inline ParseResult<Color> parseColor(parser::ParseStream &stream)
+    {
+        const auto maybeVal = stream.peek();
+        for(std::size_t i = 0; i < COLOR_COUNT; ++i)
+        {
+            if(maybeVal == COLOR_NAMES[i].front())
+            {
+                if(auto result = parseLiteral(stream, COLOR_NAMES[i], "color");
+                   !result)
+                {
+                    return std::unexpected(result.error());
+                }
+                return static_cast<Color>(i);
+            }
+        }
+        return stream.fail(maybeVal ? ErrorCode::INVALID_VALUE
+                                    : ErrorCode::UNEXPECTED_END,
+                           "color");
+    }
+}
+
+// Single pass over the line without materialising the rounds.
+inline detail::ParseResult<GameSummary> parseGameSummary(
+    const std::string_view line)
+{
+    using detail::ErrorCode;
+    parser::ParseStream stream(line);
+    GameSummary result;
+    if(auto maybeHeader = detail::parseLiteral(stream, "Game ", "game");
+       !maybeHeader)
+    {
+        return std::unexpected(maybeHeader.error());
+    }
+    const auto maybeID = detail::parseCount(stream, "game ID");
+    if(!maybeID)
+    {
+        return std::unexpected(maybeID.error());
+    }
+    result.id = *maybeID;
+    if(auto maybeSep = detail::parseLiteral(stream, ":", "game");
+       !maybeSep)
+    {
+        return std::unexpected(maybeSep.error());
+    }
+    // a colour repeated within a round adds up, as it did when parsing rounds
+    ColorCounts round{};
+    const auto closeRound = [&] {
+        for(std::size_t idx = 0; idx < round.size(); ++idx)
+        {
+            result.maxima[idx] = std::max(result.maxima[idx], round[idx]);
+        }
+        round = {};
+    };
+    while(true)
+    {
+        detail::skipSpaces(stream);
+        const auto maybeCount = detail::parseCount(stream, "color count");
+        if(!maybeCount)
+        {
+            return std::unexpected(maybeCount.error());
+        }
+        if(auto maybeSep = detail::parseLiteral(stream, " ", "color count");
+           !maybeSep)
+        {
+            return std::unexpected(maybeSep.error());
+        }
+        const auto maybeColor = detail::parseColor(stream);
+        if(!maybeColor)
+        {
+            return std::unexpected(maybeColor.error());
+        }
+        const auto idx = static_cast<std::size_t>(*maybeColor);
+        round[idx] += *maybeCount;
+        result.shownColors |= static_cast<std::uint8_t>(1U << idx);
+        const auto maybeSep = stream.read();
+        if(!maybeSep)
+        {
+            break;
+        }
+        if(*maybeSep == ';')
+        {
+            closeRound();
+        }
+        else if(*maybeSep != ',')
+        {
+            return stream.fail(ErrorCode::UNEXPECTED_CHARACTER, "round");
+        }
+    }
+    closeRound();
+    return result;
+}
+
+// Sums `func(summary)` over the games of the input, its chunks are parsed in
+// parallel.
+template<typename Func>
+std::expected<ulval, std::string> sumGames(const std::string_view input,
+                                           Func func)
+{
+    using Partial = detail::ParseResult<ulval>;
+    const auto chunks = xutil::splitChunks(input, xutil::workerCount());
+    const auto result = xutil::parallelTryReduce(
+        chunks.size(), ulval{0},
+        [&](const std::size_t begin, const std::size_t end) -> Partial {
+            ulval sum = 0;
+            std::optional<parser::ParseError> error;
+            for(auto idx = begin; idx < end && !error; ++idx)
+            {
+                xutil::forEachLine(chunks[idx], [&](const auto line) {
+                    if(error)
+                    {
+                        return;
+                    }
+                    if(const auto maybeSummary = parseGameSummary(line))
+                    {
+                        sum += func(*maybeSummary);
+                    }
+                    else
+                    {
+                        error = maybeSummary.error();
+                    }
+                });
+            }
+            if(error)
+            {
+                return std::unexpected(*error);
+            }
+            return sum;
+        });
+    if(!result)
+    {
+        return std::unexpected(result.error().message());
+    }
+    return *result;
+}
 }
 
 #endif
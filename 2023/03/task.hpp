@@ -2,9 +2,11 @@
 #define TASK_HPP
 
 #include <array>
+#include <bit>
 #include <cctype>
 #include <concepts>
 #include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <optional>
 #include <string>
@@ -12,8 +14,11 @@
 #include <type_traits>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include "../base.hpp"
+#include "../mapped_input.hpp"
+#include "../parallel.hpp"
 
 namespace task
 {
@@ -149,6 +154,272 @@ template<typename Handler>
 requires PartHandler<std::decay_t<Handler>>
 SchematicProcessor(Handler &&partHandler)
     -> SchematicProcessor<std::decay_t<Handler>>;
+
+namespace detail
+{
+    using Word = std::uint64_t;
+    constexpr std::size_t WORD_BITS = 64;
+    constexpr Word ALL_BITS = ~Word{};
+
+    // The first column >= from whose bit equals `Set`, or words * WORD_BITS.
+    template<bool Set>
+    std::size_t nextBit(const Word *mask, const std::size_t words,
+                        const std::size_t from)
+    {
+        auto idx = from / WORD_BITS;
+        if(idx >= words)
+        {
+            return words * WORD_BITS;
+        }
+        const auto load = [&](const std::size_t i) {
+            return Set ? mask[i] : ~mask[i];
+        };
+        auto bits = load(idx) & (ALL_BITS << (from % WORD_BITS));
+        while(bits == 0)
+        {
+            if(++idx == words)
+            {
+                return words * WORD_BITS;
+            }
+            bits = load(idx);
+        }
+        return idx * WORD_BITS + std::countr_zero(bits);
+    }
+
+    // Bits of the columns [begin, end) within the word idx.
+    inline Word rangeBits(const std::size_t idx, const std::size_t begin,
+                          const std::size_t end)
+    {
+        const auto first = idx * WORD_BITS;
+        const auto low = std::max(begin, first) - first;
+        const auto high = std::min(end, first + WORD_BITS) - first;
+        if(low >= high)
+        {
+            return 0;
+        }
+        const auto upper = (high == WORD_BITS ? ALL_BITS
+                                              : (Word{1} << high) - 1);
+        return upper & (ALL_BITS << low);
+    }
+}
+
+// Whole schematic kept as per-row bit masks of digits and symbols, the
+// symbol masks dilated to the 8-neighbourhood let a number be tested for
+// being a part with a few word operations. Rows are processed in bands on
+// separate threads.
+class BitSchematic
+{
+public:
+    explicit BitSchematic(std::string_view text, const char gearSymbol = '*')
+    {
+        xutil::forEachLine(text, [&](const auto line) {
+            lines.push_back(line);
+            width = std::max(width, line.size());
+        });
+        height = lines.size();
+        words = (width + detail::WORD_BITS - 1) / detail::WORD_BITS;
+        digits.resize(height * words);
+        symbols.resize(height * words);
+        gears.resize(height * words);
+        touched.resize(height * words);
+        xutil::parallelFor(height, [&](const std::size_t begin,
+                                       const std::size_t end) {
+            for(auto row = begin; row < end; ++row)
+            {
+                buildRowMasks(row, gearSymbol);
+            }
+        });
+        xutil::parallelFor(height, [&](const std::size_t begin,
+                                       const std::size_t end) {
+            for(auto row = begin; row < end; ++row)
+            {
+                dilateRow(row);
+            }
+        });
+        gearRanks.resize(height * words + 1);
+        for(std::size_t idx = 0; idx < gears.size(); ++idx)
+        {
+            gearRanks[idx + 1] = gearRanks[idx] + std::popcount(gears[idx]);
+        }
+    }
+
+    [[nodiscard]] ulval partSum() const
+    {
+        return xutil::parallelReduce(
+            height, ulval{},
+            [&](const std::size_t begin, const std::size_t end) {
+                ulval sum = 0;
+                for(auto row = begin; row < end; ++row)
+                {
+                    forEachNumber(row, [&](const auto first, const auto last,
+                                           const ulval val) {
+                        if(anyBit(touched, row, first, last))
+                        {
+                            sum += val;
+                        }
+                    });
+                }
+                return sum;
+            });
+    }
+
+    // Sum of the products of the numbers adjacent to gear symbols with
+    // exactly `valCount` of them. Every band owns the gears of its rows and
+    // also scans the numbers of the one row above and below it.
+    [[nodiscard]] ulval gearRatioSum(const std::size_t valCount) const
+    {
+        struct GearSlot
+        {
+            std::size_t count{};
+            ulval product{1};
+        };
+        std::vector<GearSlot> slots(gearRanks.back());
+        xutil::parallelFor(height, [&](const std::size_t begin,
+                                       const std::size_t end) {
+            for(auto row = (begin == 0 ? 0 : begin - 1);
+                row < std::min(end + 1, height); ++row)
+            {
+                forEachNumber(row, [&](const auto first, const auto last,
+                                       const ulval val) {
+                    const auto gearBegin = (first == 0 ? 0 : first - 1);
+                    const auto gearEnd = std::min(last + 1, width);
+                    for(auto gearRow = std::max(row, begin + 1) - 1;
+                        gearRow < std::min({row + 2, end, height}); ++gearRow)
+                    {
+                        forEachGear(gearRow, gearBegin, gearEnd,
+                                    [&](const std::size_t id) {
+                                        auto &slot = slots[id];
+                                        ++slot.count;
+                                        slot.product *= val;
+                                    });
+                    }
+                });
+            }
+        });
+        ulval sum = 0;
+        for(const auto &slot : slots)
+        {
+            if(slot.count == valCount)
+            {
+                sum += slot.product;
+            }
+        }
+        return sum;
+    }
+
+private:
+    void buildRowMasks(const std::size_t row, const char gearSymbol)
+    {
+        const auto line = lines[row];
+        for(std::size_t col = 0; col < line.size(); ++col)
+        {
+            const auto bit = detail::Word{1} << (col % detail::WORD_BITS);
+            const auto idx = row * words + col / detail::WORD_BITS;
+            const auto val = line[col];
+            if(val >= '0' && val <= '9')
+            {
+                digits[idx] |= bit;
+            }
+            else if(val != '.' && std::ispunct(static_cast<unsigned char>(val)))
+            {
+                symbols[idx] |= bit;
+                if(val == gearSymbol)
+                {
+                    gears[idx] |= bit;
+                }
+            }
+        }
+    }
+
+    void dilateRow(const std::size_t row)
+    {
+        for(auto neighbour = (row == 0 ? 0 : row - 1);
+            neighbour < std::min(row + 2, height); ++neighbour)
+        {
+            const auto *src = &symbols[neighbour * words];
+            for(std::size_t idx = 0; idx < words; ++idx)
+            {
+                auto bits = src[idx] | (src[idx] << 1) | (src[idx] >> 1);
+                if(idx > 0)
+                {
+                    bits |= src[idx - 1] >> (detail::WORD_BITS - 1);
+                }
+                if(idx + 1 < words)
+                {
+                    bits |= src[idx + 1] << (detail::WORD_BITS - 1);
+                }
+                touched[row * words + idx] |= bits;
+            }
+        }
+    }
+
+    // Calls `func(first, last, value)` for the digit runs [first, last).
+    template<typename Func>
+    void forEachNumber(const std::size_t row, Func &&func) const
+    {
+        const auto *mask = &digits[row * words];
+        const auto line = lines[row];
+        auto col = detail::nextBit<true>(mask, words, 0);
+        while(col < line.size())
+        {
+            const auto last = detail::nextBit<false>(mask, words, col);
+            ulval val = 0;
+            for(auto idx = col; idx < last; ++idx)
+            {
+                val = val * 10 + static_cast<ulval>(line[idx] - '0');
+            }
+            func(col, last, val);
+            col = detail::nextBit<true>(mask, words, last);
+        }
+    }
+
+    [[nodiscard]] bool anyBit(const std::vector<detail::Word> &mask,
+                              const std::size_t row, const std::size_t first,
+                              const std::size_t last) const
+    {
+        for(auto idx = first / detail::WORD_BITS;
+            idx * detail::WORD_BITS < last; ++idx)
+        {
+            if(mask[row * words + idx] & detail::rangeBits(idx, first, last))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Calls `func(id)` for the gears in the columns [first, last), the id is
+    // the rank of the gear bit among all of them.
+    template<typename Func>
+    void forEachGear(const std::size_t row, const std::size_t first,
+                     const std::size_t last, Func &&func) const
+    {
+        for(auto idx = first / detail::WORD_BITS;
+            idx * detail::WORD_BITS < last; ++idx)
+        {
+            const auto wordIdx = row * words + idx;
+            auto bits = gears[wordIdx] & detail::rangeBits(idx, first, last);
+            while(bits != 0)
+            {
+                const auto bit = std::countr_zero(bits);
+                func(gearRanks[wordIdx] +
+                     std::popcount(gears[wordIdx] &
+                                   ((detail::Word{1} << bit) - 1)));
+                bits &= bits - 1;
+            }
+        }
+    }
+
+    std::vector<std::string_view> lines;
+    std::size_t width{};
+    std::size_t height{};
+    std::size_t words{};
+    std::vector<detail::Word> digits;
+    std::vector<detail::Word> symbols;
+    std::vector<detail::Word> gears;
+    std::vector<detail::Word> touched;
+    std::vector<std::size_t> gearRanks;
+};
 }
 
 #endif
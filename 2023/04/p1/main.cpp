@@ -1,50 +1,45 @@
-#include <algorithm>
-#include <functional>
+#include <format>
 #include <iostream>
-#include <iterator>
-#include <ranges>
+#include <limits>
+#include <optional>
 #include <stdexcept>
-#include <string>
 
+#include "../../mapped_input.hpp"
 #include "../task.hpp"
 
 namespace
 {
-task::ulval cardPoints(const task::Card &card)
+// std::nullopt when the points don't fit ulval.
+std::optional<task::ulval> cardPoints(const task::Card &card)
 {
-    return std::ranges::fold_left(card.numbers, static_cast<task::ulval>(0),
-                                  [&](const auto cur, const auto val) {
-                                      const task::ulval found =
-                                          card.wins.contains(val);
-                                      return std::max(found, cur * (found + 1));
-                                  });
+    const auto matches = card.matches();
+    if(matches > std::numeric_limits<task::ulval>::digits)
+    {
+        return std::nullopt;
+    }
+    return matches == 0 ? 0 : task::ulval{1} << (matches - 1);
 }
 }
 
 int main()
 {
+    const xutil::MappedInput input;
     task::ulval totalPoints = 0;
-    for(const auto &line :
-        std::ranges::subrange(std::istreambuf_iterator<char>{std::cin},
-                              std::istreambuf_iterator<char>{}) |
-            std::views::lazy_split('\n') |
-            std::views::transform([](auto lineView) {
-                std::string line;
-                std::ranges::copy(lineView, std::back_inserter(line));
-                return line;
-            }))
-    {
-        if(line.empty())
-        {
-            continue;
-        }
+    xutil::forEachLine(input.view(), [&](const auto line) {
         const auto maybeCard = task::parseCard(line);
         if(!maybeCard)
         {
-            throw std::runtime_error("invalid input");
+            throw std::runtime_error(
+                std::format("invalid input: {}", maybeCard.error().message()));
         }
-        totalPoints += cardPoints(*maybeCard);
-    }
+        const auto maybePoints = cardPoints(*maybeCard);
+        if(!maybePoints)
+        {
+            throw std::runtime_error(std::format(
+                "card points overflow: matches={}", maybeCard->matches()));
+        }
+        totalPoints += *maybePoints;
+    });
     std::cout << totalPoints << '\n';
     return 0;
 }
@@ -1,77 +1,59 @@
-#include <algorithm>
+#include <array>
 #include <cstddef>
-#include <functional>
+#include <format>
 #include <iostream>
-#include <iterator>
-#include <ranges>
 #include <stdexcept>
-#include <string>
 #include <utility>
-#include <vector>
 
+#include "../../mapped_input.hpp"
 #include "../task.hpp"
 
 namespace
 {
-task::uval cardMatches(const task::Card &card)
+// Copies won by the cards seen so far, kept as a difference array: a card
+// with `matches` matches adds its copies to the range of following cards by
+// updating the two range ends only. A card cannot match more than
+// MAX_NUMBER numbers, so a ring of that many entries is enough.
+class CardCascade
 {
-    return std::ranges::fold_left(
-        card.numbers | std::views::transform([&](const auto val) {
-            return static_cast<task::uval>(card.wins.contains(val));
-        }),
-        static_cast<task::uval>(0), std::plus<>{});
-}
-
-template<std::ranges::random_access_range R>
-task::ulval totalCards(const R &cards)
-{
-    const auto size = std::ranges::size(cards);
-    if(size == 0)
+public:
+    void add(const task::uval matches)
     {
-        return 0;
+        won += std::exchange(diff[idx % RING_SIZE], 0);
+        const auto copies = won + 1;
+        diff[(idx + 1) % RING_SIZE] += copies;
+        diff[(idx + matches + 1) % RING_SIZE] -= copies;
+        total += copies;
+        ++idx;
     }
-    std::vector<task::ulval> cardWins(size, 0);
-    for(auto i = size; i > 0; --i)
+
+    [[nodiscard]] task::ulval totalCards() const
     {
-        const auto idx = i - 1;
-        const auto matches = cardMatches(cards[idx]);
-        auto &curWins = cardWins[idx];
-        curWins = 1;
-        for(std::size_t j = 0; j < matches && idx + 1 + j < cardWins.size();
-            ++j)
-        {
-            curWins += cardWins[idx + 1 + j];
-        }
+        return total;
     }
-    return std::ranges::fold_left(cardWins, static_cast<task::ulval>(0),
-                                  std::plus<>{});
-}
+
+private:
+    static constexpr std::size_t RING_SIZE = task::MAX_NUMBER + 2;
+    std::array<task::ulval, RING_SIZE> diff{};
+    std::size_t idx{};
+    task::ulval won{};
+    task::ulval total{};
+};
 }
 
 int main()
 {
-    std::vector<task::Card> cards;
-    for(const auto &line :
-        std::ranges::subrange(std::istreambuf_iterator<char>{std::cin},
-                              std::istreambuf_iterator<char>{}) |
-            std::views::lazy_split('\n') |
-            std::views::transform([](auto lineView) {
-                std::string line;
-                std::ranges::copy(lineView, std::back_inserter(line));
-                return line;
-            }))
-    {
-        if(line.empty())
-        {
-            continue;
-        }
-        auto maybeCard = task::parseCard(line);
+    const xutil::MappedInput input;
+    CardCascade cascade;
+    xutil::forEachLine(input.view(), [&](const auto line) {
+        const auto maybeCard = task::parseCard(line);
         if(!maybeCard)
         {
-            throw std::runtime_error("invalid input");
+            throw std::runtime_error(
+                std::format("invalid input: {}", maybeCard.error().message()));
         }
-        cards.push_back(std::move(*maybeCard));
-    }
-    std::cout << totalCards(cards) << '\n';
+        cascade.add(maybeCard->matches());
+    });
+    std::cout << cascade.totalCards() << '\n';
     return 0;
 }
@@ -1,69 +1,148 @@
 #ifndef TASK_HPP
 #define TASK_HPP
 
-#include <algorithm>
-#include <cassert>
+#include <bitset>
+#include <cstddef>
 #include <expected>
-#include <functional>
-#include <iterator>
-#include <ranges>
-#include <regex>
-#include <string>
+#include <limits>
 #include <string_view>
-#include <unordered_set>
-#include <vector>
 
-#include "../base.hpp"
+#include "../parse_stream.hpp"
 
 namespace task
 {
 using uval = unsigned int;
 using ulval = unsigned long long int;
 
+constexpr std::size_t MAX_NUMBER = 128;
+using NumberSet = std::bitset<MAX_NUMBER>;
+
 struct Card
 {
-    std::unordered_set<uval> wins;
-    std::vector<uval> numbers;
+    NumberSet wins;
+    NumberSet numbers;
+
+    [[nodiscard]] uval matches() const
+    {
+        return static_cast<uval>((wins & numbers).count());
+    }
 };
 
-inline std::expected<Card, std::string> parseCard(const std::string &cardStr)
+namespace detail
 {
-    const std::regex cardRegex{R"(Card +\d+: *((\d+ *)+)\| *((\d+ *)+))"};
-    constexpr auto extractNumbers = [](auto &inp) {
-        return inp | std::views::split(' ') |
-               std::views::filter(std::not_fn(std::ranges::empty)) |
-               std::views::transform([](auto numberView) {
-                   const std::string_view numberStr(
-                       std::ranges::begin(numberView),
-                       std::ranges::end(numberView));
-                   return base::parseValue<uval>(numberStr);
-               });
-    };
-    constexpr auto expectValue = [](const auto &maybeValue) {
-        assert(maybeValue);
-        return *maybeValue;
-    };
-    if(std::smatch match; std::regex_match(cardStr, match, cardRegex))
+    template<typename T>
+    using ParseResult = std::expected<T, parser::ParseError>;
+    using ErrorCode = parser::ParseErrorCode;
+
+    inline void skipSpaces(parser::ParseStream &stream)
     {
-        Card card{};
+        while(stream.peek() == ' ')
         {
-            const auto &winsMatch = match[1];
-            std::ranges::subrange winsRange(winsMatch.first, winsMatch.second);
-            std::ranges::copy(extractNumbers(winsRange) |
-                                  std::views::transform(expectValue),
-                              std::inserter(card.wins, end(card.wins)));
+            stream.read();
         }
+    }
+
+    inline ParseResult<void> parseChar(parser::ParseStream &stream,
+                                       const char expected,
+                                       const char *context)
+    {
+        const auto maybeVal = stream.read();
+        if(maybeVal != expected)
         {
-            const auto &numbersMatch = match[3];
-            std::ranges::subrange numbersRange(numbersMatch.first,
-                                               numbersMatch.second);
-            std::ranges::copy(extractNumbers(numbersRange) |
-                                  std::views::transform(expectValue),
-                              std::back_inserter(card.numbers));
+            return stream.fail(maybeVal ? ErrorCode::UNEXPECTED_CHARACTER
+                                        : ErrorCode::UNEXPECTED_END,
+                               context);
         }
-        return card;
+        return {};
+    }
+
+    inline ParseResult<uval> parseValue(parser::ParseStream &stream,
+                                        const uval limit, const char *context)
+    {
+        uval result = 0;
+        std::size_t digits = 0;
+        while(const auto maybeVal = stream.peek())
+        {
+            if(*maybeVal < '0' || *maybeVal > '9')
+            {
+                break;
+            }
+            const auto digit = static_cast<uval>(*maybeVal - '0');
+            if(result > (limit - 1 - digit) / 10)
+            {
+                return stream.fail(ErrorCode::INVALID_VALUE, context);
+            }
+            result = result * 10 + digit;
+            ++digits;
+            stream.read();
+        }
+        if(digits == 0)
+        {
+            return stream.fail(ErrorCode::EMPTY_TOKEN, context);
+        }
+        return result;
+    }
+
+    // Numbers separated by spaces up to `stop` or the end of the line.
+    inline ParseResult<NumberSet> parseNumbers(parser::ParseStream &stream,
+                                               const char stop)
+    {
+        NumberSet result;
+        skipSpaces(stream);
+        while(stream.peek() && stream.peek() != stop)
+        {
+            const auto maybeValue = parseValue(stream, MAX_NUMBER, "number");
+            if(!maybeValue)
+            {
+                return std::unexpected(maybeValue.error());
+            }
+            result.set(*maybeValue);
+            skipSpaces(stream);
+        }
+        return result;
+    }
+}
+
+inline detail::ParseResult<Card> parseCard(const std::string_view cardStr)
+{
+    parser::ParseStream stream(cardStr);
+    for(const auto val : std::string_view("Card"))
+    {
+        if(auto maybeHeader = detail::parseChar(stream, val, "card");
+           !maybeHeader)
+        {
+            return std::unexpected(maybeHeader.error());
+        }
+    }
+    detail::skipSpaces(stream);
+    if(auto maybeID = detail::parseValue(
+           stream, std::numeric_limits<uval>::max(), "card ID");
+       !maybeID)
+    {
+        return std::unexpected(maybeID.error());
+    }
+    if(auto maybeSep = detail::parseChar(stream, ':', "card"); !maybeSep)
+    {
+        return std::unexpected(maybeSep.error());
+    }
+    Card card{};
+    auto maybeWins = detail::parseNumbers(stream, '|');
+    if(!maybeWins)
+    {
+        return std::unexpected(maybeWins.error());
+    }
+    card.wins = *maybeWins;
+    if(auto maybeSep = detail::parseChar(stream, '|', "card"); !maybeSep)
+    {
+        return std::unexpected(maybeSep.error());
+    }
+    auto maybeNumbers = detail::parseNumbers(stream, '\0');
+    if(!maybeNumbers)
+    {
+        return std::unexpected(maybeNumbers.error());
     }
-    return std::unexpected("invalid card");
+    card.numbers = *maybeNumbers;
+    return card;
 }
 }
 
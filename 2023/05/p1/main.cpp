@@ -1,6 +1,5 @@
 #include <algorithm>
 #include <iostream>
-#include <ranges>
 #include <stdexcept>
 
 #include "../task.hpp"
@@ -13,13 +12,8 @@ task::uval lowestDestination(const task::input::Almanac &almanac)
     {
         return 0;
     }
-    const auto finalMap = std::ranges::fold_left(
-        almanac.maps, task::Map{}, [](const auto &result, const auto &map) {
-            return result.join(task::Map(map));
-        });
-    return std::ranges::min(
-        almanac.seeds |
-        std::views::transform([&](const auto seed) { return finalMap(seed); }));
+    const xutil::OffsetTable table(task::prepareAlmanacMap(almanac));
+    return std::ranges::min(table.lookupBatch(almanac.seeds));
 }
 }
 
@@ -2,14 +2,11 @@
 #define TASK_HPP
 
 #include <algorithm>
-#include <cassert>
 #include <cstddef>
 #include <expected>
 #include <format>
 #include <istream>
 #include <iterator>
-#include <map>
-#include <optional>
 #include <ranges>
 #include <regex>
 #include <string>
@@ -19,6 +16,7 @@
 #include <vector>
 
 #include "../base.hpp"
+#include "../interval_set.hpp"
 
 namespace task
 {
@@ -69,141 +67,26 @@ namespace inner
     }
 }
 
-struct Range
-{
-    uval start{};
-    uval length{};
-};
+using Range = xutil::Interval<uval>;
+using Map = xutil::IntervalMap<uval>;
 
-class Map
+inline Map prepareMap(const input::Map &map)
 {
-public:
-    Map() = default;
-    explicit Map(const input::Map &map)
-        : ranges([&] {
-              std::map<uval, Range> ranges;
-              std::ranges::copy(
-                  map.ranges | std::views::transform([](const auto &rng) {
-                      return std::make_pair(rng.source,
-                                            Range{rng.destination, rng.length});
-                  }),
-                  std::inserter(ranges, end(ranges)));
-              return ranges;
-          }())
-    {
-    }
-
-    [[nodiscard]] uval operator()(const uval val) const
-    {
-        auto iter = ranges.upper_bound(val);
-        if(iter == begin(ranges))
-        {
-            return val;
-        }
-        --iter;
-        if(const auto maybeDiff =
-               intersection(val, iter->first, iter->second.length))
-        {
-            return iter->second.start + *maybeDiff;
-        }
-        return val;
-    }
-
-    [[nodiscard]] Map join(const Map &other) const
-    {
-        std::map<uval, Range> result;
-        for(const auto &[source, rng] : other.ranges)
-        {
-            const auto &destRanges = lookup({source, rng.length});
-            uval offset = 0;
-            for(const auto &dstRng : destRanges)
-            {
-                if(dstRng.start == source + offset)
-                {
-                    result.insert_or_assign(
-                        source + offset,
-                        Range{rng.start + offset, dstRng.length});
-                }
-                offset += dstRng.length;
-            }
-        }
-        for(const auto &[source, rng] : ranges)
-        {
-            const auto &destRanges = other.lookup(rng);
-            auto cur = source;
-            for(const auto &dstRng : destRanges)
-            {
-                result.insert_or_assign(cur, dstRng);
-                cur += dstRng.length;
-            }
-        }
-        return Map(std::move(result));
-    }
-
-    [[nodiscard]] std::vector<Range> lookup(const Range &rng) const
-    {
-        std::vector<Range> result;
-        auto cur = rng.start;
-        auto iter = ranges.upper_bound(cur);
-        if(iter != begin(ranges))
-        {
-            auto prev = iter;
-            --prev;
-            if(const auto maybeDiff =
-                   intersection(rng.start, prev->first, prev->second.length))
-            {
-                result.push_back(Range{
-                    prev->second.start + *maybeDiff,
-                    std::min(rng.length, prev->second.length - *maybeDiff)});
-                cur += result.back().length;
-            }
-        }
-        for(; iter != end(ranges); ++iter)
-        {
-            if(const auto maybeDiff =
-                   intersection(iter->first, rng.start, rng.length))
-            {
-                if(cur < iter->first)
-                {
-                    result.push_back(Range{cur, iter->first - cur});
-                    cur += result.back().length;
-                }
-                result.push_back(Range{
-                    iter->second.start,
-                    std::min(iter->second.length, rng.length - *maybeDiff)});
-                cur += result.back().length;
-            }
-            else
-            {
-                break;
-            }
-        }
-        if(const auto maybeDiff = intersection(cur, rng.start, rng.length))
-        {
-            result.push_back(Range{cur, rng.length - *maybeDiff});
-        }
-        return result;
-    }
-
-private:
-    explicit Map(std::map<uval, Range> ranges) : ranges(std::move(ranges))
-    {
-    }
-
-    static constexpr std::optional<uval> intersection(const uval value,
-                                                      const uval source,
-                                                      const uval length)
-    {
-        assert(value >= source);
-        if(const auto diff = value - source; diff < length)
-        {
-            return diff;
-        }
-        return std::nullopt;
-    }
+    return Map(map.ranges | std::views::transform([](const auto &rng) {
+                   return Map::Piece{
+                       {rng.source, rng.source + rng.length},
+                       rng.destination,
+                   };
+               }));
+}
 
-    std::map<uval, Range> ranges;
-};
+inline Map prepareAlmanacMap(const input::Almanac &almanac)
+{
+    return std::ranges::fold_left(almanac.maps, Map{},
+                                  [](const auto &result, const auto &map) {
+                                      return result.then(prepareMap(map));
+                                  });
+}
 
 inline std::expected<input::Almanac, std::string> parseAlmanac(
     std::istream &stream)
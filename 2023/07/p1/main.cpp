@@ -29,6 +29,6 @@ int main()
         }
         plays.push_back(*maybePlay);
     }
-    std::cout << task::totalWinnings<task::HandOrder<>>(plays) << '\n';
+    std::cout << task::totalWinnings(plays) << '\n';
     return 0;
 }
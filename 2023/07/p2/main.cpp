@@ -31,6 +31,6 @@ int main()
         }
         plays.push_back(*maybePlay);
     }
-    std::cout << task::totalWinnings<task::HandOrder<true>>(plays) << '\n';
+    std::cout << task::totalWinnings<true>(plays) << '\n';
     return 0;
 }
@@ -3,17 +3,14 @@
 
 #include <algorithm>
 #include <array>
-#include <compare>
 #include <concepts>
 #include <cstddef>
+#include <cstdint>
 #include <expected>
 #include <format>
-#include <functional>
-#include <iterator>
+#include <numeric>
 #include <ranges>
-#include <span>
 #include <string>
-#include <tuple>
 #include <utility>
 #include <vector>
 
@@ -42,12 +39,35 @@ using uval = unsigned int;
 using ulval = unsigned long long int;
 using Hand = std::array<Card, HAND_CARDS>;
 
-template<bool Joker = false>
-class HandOrder
+namespace detail
 {
-    static constexpr auto cardRank(const Card card)
+    constexpr std::size_t CARD_KINDS = std::to_underlying(Card::A) + 1;
+    constexpr std::size_t CARD_BITS = 4;
+    constexpr std::size_t HAND_TYPE_SHIFT = CARD_BITS * HAND_CARDS;
+
+    using HandTypes = std::array<std::array<uval, HAND_CARDS + 1>,
+                                 HAND_CARDS + 1>;
+
+    // Hand type rank indexed by the two largest counts of equal cards, the
+    // feasible signatures of a hand are ranked in lexicographic order.
+    constexpr HandTypes HAND_TYPES = [] {
+        HandTypes result{};
+        uval rank = 0;
+        for(std::size_t first = 1; first <= HAND_CARDS; ++first)
+        {
+            for(std::size_t second = (first == HAND_CARDS ? 0 : 1);
+                second <= std::min(first, HAND_CARDS - first); ++second)
+            {
+                result[first][second] = rank++;
+            }
+        }
+        return result;
+    }();
+
+    template<bool Joker>
+    constexpr uval cardRank(const Card card)
     {
-        const auto val = std::to_underlying(card);
+        const auto val = static_cast<uval>(std::to_underlying(card));
         if constexpr(Joker)
         {
             return card != Card::J ? val + 1 : 0;
@@ -57,76 +77,37 @@ class HandOrder
             return val;
         }
     }
+}
 
-    static constexpr auto prepareHandTypeRank(const Hand &hand)
-    {
-        std::array<uval, std::to_underlying(Card::A) + 1> cardCounts{};
-        for(const auto c : hand)
-        {
-            cardCounts[std::to_underlying(c)] += 1;
-        }
-        uval jokers = 0;
-        if constexpr(Joker)
-        {
-            auto &jokerCnt = cardCounts[std::to_underlying(Card::J)];
-            jokers = jokerCnt;
-            jokerCnt = 0;
-        }
-        std::ranges::partial_sort(
-            cardCounts, std::ranges::begin(cardCounts) + HAND_TYPE_RANK_CARDS,
-            std::greater<>{});
-        cardCounts[0] += jokers;
-        HandTypeRank result{};
-        std::ranges::copy(cardCounts | std::views::take(HAND_TYPE_RANK_CARDS),
-                          std::ranges::begin(result));
-        return result;
-    }
+using HandKey = std::uint32_t;
 
-public:
-    explicit constexpr HandOrder(const Hand &hand)
-        : handTypeRank(prepareHandTypeRank(hand)), handSpan(hand)
+// Hand type rank in the high bits followed by the card ranks, 4 bits each,
+// so that the keys order like the hands.
+template<bool Joker = false>
+constexpr HandKey handKey(const Hand &hand)
+{
+    std::array<uval, detail::CARD_KINDS> cardCounts{};
+    HandKey key = 0;
+    for(const auto card : hand)
     {
+        ++cardCounts[std::to_underlying(card)];
+        key = (key << detail::CARD_BITS) | detail::cardRank<Joker>(card);
     }
-
-    friend constexpr std::strong_ordering operator<=>(const HandOrder &left,
-                                                      const HandOrder &right)
+    uval jokers = 0;
+    if constexpr(Joker)
     {
-        constexpr auto cmpCol = [](const auto &left, const auto &right) {
-            const auto [leftIter, rightIter] =
-                std::ranges::mismatch(left, right);
-            if(leftIter != std::ranges::end(left))
-            {
-                return *leftIter <=> *rightIter;
-            }
-            return std::strong_ordering::equal;
-        };
-        constexpr auto prepareCardRanks = [](auto &cards) {
-            return cards | std::views::transform(cardRank);
-        };
-        if(const auto handTypeCmp =
-               cmpCol(left.handTypeRank, right.handTypeRank);
-           handTypeCmp != 0)
-        {
-            return handTypeCmp;
-        }
-        return cmpCol(prepareCardRanks(left.handSpan),
-                      prepareCardRanks(right.handSpan));
+        jokers = std::exchange(cardCounts[std::to_underlying(Card::J)], 0);
     }
-
-    friend constexpr bool operator==(const HandOrder &left,
-                                     const HandOrder &right)
+    uval first = 0;
+    uval second = 0;
+    for(const auto count : cardCounts)
     {
-        return (left <=> right) == 0;
+        second = std::max(second, std::min(first, count));
+        first = std::max(first, count);
     }
-
-private:
-    static constexpr std::size_t HAND_TYPE_RANK_CARDS = 2;
-
-    using HandTypeRank = std::array<uval, HAND_TYPE_RANK_CARDS>;
-
-    HandTypeRank handTypeRank;
-    std::span<const Card, HAND_CARDS> handSpan;
-};
+    return key | (detail::HAND_TYPES[first + jokers][second]
+                  << detail::HAND_TYPE_SHIFT);
+}
 
 namespace input
 {
@@ -137,26 +118,69 @@ namespace input
     };
 }
 
-template<std::constructible_from<Hand> Order,
-         std::ranges::random_access_range R>
-requires std::totally_ordered<Order> &&
-         std::same_as<std::ranges::range_value_t<R>, input::Play>
+namespace detail
+{
+    // LSD radix sort by bytes, the passes where all the values share the
+    // byte are skipped.
+    inline void radixSort(std::vector<std::uint64_t> &values)
+    {
+        constexpr std::size_t BYTE_BITS = 8;
+        constexpr std::size_t BUCKETS = std::size_t{1} << BYTE_BITS;
+        constexpr std::size_t PASSES = sizeof(std::uint64_t);
+        std::array<std::array<std::size_t, BUCKETS>, PASSES> counts{};
+        for(const auto val : values)
+        {
+            for(std::size_t pass = 0; pass < PASSES; ++pass)
+            {
+                ++counts[pass][(val >> (pass * BYTE_BITS)) & (BUCKETS - 1)];
+            }
+        }
+        std::vector<std::uint64_t> buffer(values.size());
+        for(std::size_t pass = 0; pass < PASSES; ++pass)
+        {
+            auto &passCounts = counts[pass];
+            if(std::ranges::find(passCounts, values.size()) !=
+               passCounts.end())
+            {
+                continue;
+            }
+            std::exclusive_scan(passCounts.begin(), passCounts.end(),
+                                passCounts.begin(), std::size_t{});
+            for(const auto val : values)
+            {
+                buffer[passCounts[(val >> (pass * BYTE_BITS)) &
+                                  (BUCKETS - 1)]++] = val;
+            }
+            values.swap(buffer);
+        }
+    }
+}
+
+template<bool Joker = false, std::ranges::input_range R>
+requires std::same_as<std::ranges::range_value_t<R>, input::Play>
 ulval totalWinnings(const R &plays)
 {
-    std::vector<std::tuple<Order, uval>> sortedBids;
-    sortedBids.reserve(std::ranges::size(plays));
-    std::ranges::copy(plays | std::views::transform([](const auto &play) {
-                          return std::tuple{Order(play.hand), play.bid};
-                      }),
-                      std::back_inserter(sortedBids));
-    std::ranges::sort(sortedBids);
-    return std::ranges::fold_left(std::views::enumerate(sortedBids) |
-                                      std::views::transform([](const auto &p) {
-                                          const auto &[idx, bid] = p;
-                                          return (static_cast<ulval>(idx) + 1) *
-                                                 std::get<1>(bid);
-                                      }),
-                                  static_cast<ulval>(0), std::plus<>{});
+    constexpr std::size_t BID_BITS = 32;
+    std::vector<std::uint64_t> sortedBids;
+    if constexpr(std::ranges::sized_range<R>)
+    {
+        sortedBids.reserve(std::ranges::size(plays));
+    }
+    for(const auto &play : plays)
+    {
+        sortedBids.push_back(
+            (static_cast<std::uint64_t>(handKey<Joker>(play.hand))
+             << BID_BITS) |
+            play.bid);
+    }
+    detail::radixSort(sortedBids);
+    ulval result = 0;
+    for(std::size_t idx = 0; idx < sortedBids.size(); ++idx)
+    {
+        const auto bid = sortedBids[idx] & ((std::uint64_t{1} << BID_BITS) - 1);
+        result += (static_cast<ulval>(idx) + 1) * bid;
+    }
+    return result;
 }
 
 namespace detail
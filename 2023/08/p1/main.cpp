@@ -7,21 +7,28 @@
 
 namespace
 {
-std::optional<task::Size> stepsToReach(const task::Map &map,
-                                       const task::Path &path,
+// Walks at most until the (node, path position) states must repeat.
+std::optional<task::Size> stepsToReach(const task::Network &network,
                                        const task::Node &source,
                                        const task::Node &target)
 {
-    std::optional<task::Size> steps;
-    task::traverse(map, path, source, [&](const auto &node, const auto idx) {
-        if(node == target)
+    const auto maybeSource = network.find(source);
+    const auto maybeTarget = network.find(target);
+    if(!maybeSource || !maybeTarget || network.pathSize() == 0)
+    {
+        return std::nullopt;
+    }
+    auto cur = *maybeSource;
+    const auto limit = network.size() * network.pathSize();
+    for(task::Size idx = 0; idx <= limit && cur != task::NO_NODE; ++idx)
+    {
+        if(cur == *maybeTarget)
         {
-            steps = idx;
-            return false;
+            return idx;
         }
-        return true;
-    });
-    return steps;
+        cur = network.step(cur, idx);
+    }
+    return std::nullopt;
 }
 }
 
@@ -33,10 +40,10 @@ int main()
         throw std::runtime_error(
             std::format("input parsing error: {}", maybeInput.error()));
     }
+    const task::Network network(*maybeInput);
     const task::Node source("AAA");
     const task::Node target("ZZZ");
-    const auto maybeSteps =
-        stepsToReach(maybeInput->map, maybeInput->path, source, target);
+    const auto maybeSteps = stepsToReach(network, source, target);
     if(!maybeSteps)
     {
         throw std::runtime_error("target unreachable");
@@ -1,21 +1,13 @@
 #include <algorithm>
 #include <format>
 #include <iostream>
-#include <numeric>
 #include <ranges>
 #include <stdexcept>
+#include <vector>
 
+#include "../../intmath.hpp"
 #include "../task.hpp"
 
-namespace
-{
-constexpr task::Size commonCycle(const task::Size left, const task::Size right)
-{
-    const auto g = std::gcd(left, right);
-    return (left / g) * (right / g) * g;
-}
-}
-
 int main()
 {
     const auto maybeInput = task::input::parseInput(std::cin);
@@ -24,20 +16,30 @@ int main()
         throw std::runtime_error(
             std::format("input parsing error: {}", maybeInput.error()));
     }
-    const auto cycle = std::ranges::fold_left(
-        maybeInput->map | std::views::filter([](const auto &connection) {
-            return connection.first.ends_with('A');
-        }) | std::views::transform([&](const auto &connection) {
-            const auto maybePathCharacteristic = task::pathCharacteristic(
-                maybeInput->map, maybeInput->path, connection.first,
-                [](const auto &node) { return node.ends_with('Z'); });
+    const task::Network network(*maybeInput);
+    std::vector<task::NodeId> starts;
+    for(task::NodeId node = 0; node < network.size(); ++node)
+    {
+        if(network.name(node).ends_with('A'))
+        {
+            starts.push_back(node);
+        }
+    }
+    const auto characteristics = network.characteristics(
+        starts, [](const auto &node) { return node.ends_with('Z'); });
+    const auto maybeCycle = numutil::checkedLcm(
+        characteristics |
+        std::views::transform([](const auto &maybePathCharacteristic) {
             if(maybePathCharacteristic)
             {
                 return maybePathCharacteristic->cycle.length;
             }
             return static_cast<task::Size>(1);
-        }),
-        static_cast<task::Size>(1), commonCycle);
-    std::cout << cycle << '\n';
+        }));
+    if(!maybeCycle)
+    {
+        throw std::runtime_error("common cycle overflow");
+    }
+    std::cout << *maybeCycle << '\n';
     return 0;
 }
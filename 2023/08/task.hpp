@@ -5,11 +5,13 @@
 #include <array>
 #include <cassert>
 #include <cstddef>
+#include <cstdint>
 #include <expected>
 #include <format>
 #include <functional>
 #include <istream>
 #include <iterator>
+#include <limits>
 #include <optional>
 #include <ranges>
 #include <regex>
@@ -20,6 +22,9 @@
 #include <utility>
 #include <vector>
 
+#include "../cycle.hpp"
+#include "../parallel.hpp"
+
 namespace task
 {
 enum class Dir
@@ -140,96 +145,227 @@ namespace input
     }
 }
 
-namespace detail
+using NodeId = std::uint32_t;
+constexpr NodeId NO_NODE = std::numeric_limits<NodeId>::max();
+
+// The map compiled to dense node ids: the successors of every direction are
+// kept in flat arrays, the whole path is precomposed into the successor
+// after one pass, with binary lifting tables for repeated passes. Nodes
+// without a connection, and the nodes leading to them, lead to NO_NODE.
+class Network
 {
-    struct PathState
+public:
+    explicit Network(const input::Input &input) : path(input.path)
+    {
+        for(const auto &[node, neighbours] : input.map)
+        {
+            intern(node);
+            for(const auto &neighbour : neighbours)
+            {
+                intern(neighbour);
+            }
+        }
+        for(auto &successors : neighbourIds)
+        {
+            successors.assign(names.size(), NO_NODE);
+        }
+        for(const auto &[node, neighbours] : input.map)
+        {
+            for(std::size_t dir = 0; dir < NEIGHBOURS; ++dir)
+            {
+                neighbourIds[dir][ids.at(node)] = ids.at(neighbours[dir]);
+            }
+        }
+        if(path.empty())
+        {
+            return;
+        }
+        auto &passJumps = jumps.emplace_back(names.size());
+        xutil::parallelFor(names.size(), [&](const Size begin,
+                                             const Size end) {
+            for(auto node = begin; node < end; ++node)
+            {
+                auto cur = static_cast<NodeId>(node);
+                for(Size idx = 0; idx < path.size() && cur != NO_NODE; ++idx)
+                {
+                    cur = step(cur, idx);
+                }
+                passJumps[node] = cur;
+            }
+        });
+        // after names.size() passes every walk is on its cycle, see after()
+        while((Size{1} << (jumps.size() - 1)) < names.size())
+        {
+            const auto &prev = jumps.back();
+            std::vector<NodeId> next(names.size());
+            for(Size node = 0; node < names.size(); ++node)
+            {
+                next[node] = (prev[node] == NO_NODE ? NO_NODE
+                                                    : prev[prev[node]]);
+            }
+            jumps.push_back(std::move(next));
+        }
+    }
+
+    [[nodiscard]] std::optional<NodeId> find(const Node &name) const
     {
-        Node node{};
-        Size pathIdx{};
+        if(const auto iter = ids.find(name); iter != end(ids))
+        {
+            return iter->second;
+        }
+        return std::nullopt;
+    }
 
-        friend auto operator<=>(const PathState &, const PathState &) = default;
-    };
-}
-}
+    [[nodiscard]] const Node &name(const NodeId node) const
+    {
+        return names[node];
+    }
 
-template<>
-struct std::hash<task::detail::PathState>
-{
-    std::size_t operator()(const task::detail::PathState &state) const
+    [[nodiscard]] Size size() const
     {
-        const auto h1 = std::hash<decltype(state.node)>{}(state.node);
-        const auto h2 = std::hash<decltype(state.pathIdx)>{}(state.pathIdx);
-        return h1 ^ (h2 << 1);
+        return names.size();
     }
-};
 
-namespace task
-{
-template<typename Visitor>
-requires std::is_invocable_r_v<bool, Visitor, Node, Size>
-void traverse(const Map &map, const Path &path, const Node &source,
-              Visitor &&visitor)
-{
-    if(path.empty())
+    [[nodiscard]] Size pathSize() const
+    {
+        return path.size();
+    }
+
+    // The successor of `node` visited at step `idx`.
+    [[nodiscard]] NodeId step(const NodeId node, const Size idx) const
+    {
+        return neighbourIds[std::to_underlying(path[idx % path.size()])][node];
+    }
+
+    [[nodiscard]] NodeId afterPass(const NodeId node) const
     {
-        return;
+        return jumps.front()[node];
     }
-    const auto pathSize = path.size();
-    auto *cur = &source;
-    Size idx = 0;
-    while(true)
+
+    [[nodiscard]] NodeId after(NodeId node, const Size steps) const
     {
-        if(!visitor(*cur, idx))
+        if(path.empty())
+        {
+            return node;
+        }
+        auto passes = steps / path.size();
+        if(const auto lifted = (Size{1} << jumps.size()) - 1; passes > lifted)
         {
-            break;
+            node = passWithLifting(node, lifted);
+            passes -= lifted;
+            if(node == NO_NODE)
+            {
+                return NO_NODE;
+            }
+            const auto maybeCycle = xutil::findCycle(
+                node, [&](const NodeId cur) { return afterPass(cur); });
+            passes %= maybeCycle->length;
         }
-        const auto iter = map.find(*cur);
-        if(iter == end(map))
+        node = passWithLifting(node, passes);
+        for(Size idx = 0; idx < steps % path.size() && node != NO_NODE; ++idx)
         {
-            break;
+            node = step(node, idx);
         }
-        cur = &iter->second[std::to_underlying(path[idx % pathSize])];
-        ++idx;
+        return node;
     }
-}
 
-template<typename Func>
-requires std::is_invocable_r_v<bool, Func, Node>
-std::optional<PathCharacteristic> pathCharacteristic(const Map &map,
-                                                     const Path &path,
-                                                     const Node &source,
-                                                     Func &&checkZero)
-{
-    std::unordered_map<detail::PathState, Size> seenStates;
-    std::vector<Size> zeros;
-    std::optional<detail::PathState> cycleState;
-    task::Size cycleIdx{};
-    traverse(map, path, source, [&](const auto &node, const auto idx) {
-        const auto pathIdx = idx % path.size();
-        if(detail::PathState state{node, pathIdx};
-           !seenStates.emplace(state, idx).second)
-        {
-            cycleState = std::move(state);
-            cycleIdx = idx;
-            return false;
-        }
-        if(checkZero(node))
-        {
-            zeros.push_back(idx);
-        }
-        return true;
-    });
-    if(!cycleState)
+    // The loop of the (node, path position) walk from `start` and the steps
+    // before its end where a node in `zeros` is visited, std::nullopt when
+    // the walk leads to NO_NODE.
+    [[nodiscard]] std::optional<PathCharacteristic> characteristic(
+        const NodeId start, const std::vector<bool> &zeros) const
     {
-        return std::nullopt;
+        if(path.empty())
+        {
+            return std::nullopt;
+        }
+        const auto maybePassCycle = xutil::findCycle(
+            start, [&](const NodeId node) -> std::optional<NodeId> {
+                if(const auto next = afterPass(node); next != NO_NODE)
+                {
+                    return next;
+                }
+                return std::nullopt;
+            });
+        if(!maybePassCycle)
+        {
+            return std::nullopt;
+        }
+        // the step loop starts within the pass preceding the pass loop
+        const auto length = maybePassCycle->length * path.size();
+        auto init = (maybePassCycle->start == 0
+                         ? 0
+                         : (maybePassCycle->start - 1) * path.size());
+        auto head = after(start, init);
+        auto ahead = after(start, init + length);
+        while(head != ahead)
+        {
+            head = step(head, init);
+            ahead = step(ahead, init);
+            ++init;
+        }
+        PathCharacteristic result{{init, length}, {}};
+        auto cur = start;
+        for(Size idx = 0; idx < init + length; ++idx)
+        {
+            if(zeros[cur])
+            {
+                result.zeros.push_back(idx);
+            }
+            cur = step(cur, idx);
+        }
+        return result;
     }
-    const auto initIter = seenStates.find(*cycleState);
-    assert(initIter != end(seenStates));
-    return PathCharacteristic{
-        {initIter->second, cycleIdx - initIter->second},
-        std::move(zeros),
-    };
-}
+
+    // characteristic() of all the starts, computed in parallel.
+    template<typename Func>
+    requires std::is_invocable_r_v<bool, Func, Node>
+    std::vector<std::optional<PathCharacteristic>> characteristics(
+        const std::vector<NodeId> &starts, Func &&checkZero) const
+    {
+        std::vector<bool> zeros(names.size());
+        for(Size node = 0; node < names.size(); ++node)
+        {
+            zeros[node] = checkZero(names[node]);
+        }
+        std::vector<std::optional<PathCharacteristic>> result(starts.size());
+        xutil::parallelFor(starts.size(), [&](const Size begin,
+                                              const Size end) {
+            for(auto idx = begin; idx < end; ++idx)
+            {
+                result[idx] = characteristic(starts[idx], zeros);
+            }
+        });
+        return result;
+    }
+
+private:
+    void intern(const Node &name)
+    {
+        if(ids.emplace(name, static_cast<NodeId>(names.size())).second)
+        {
+            names.push_back(name);
+        }
+    }
+
+    [[nodiscard]] NodeId passWithLifting(NodeId node, const Size passes) const
+    {
+        for(Size level = 0; level < jumps.size() && node != NO_NODE; ++level)
+        {
+            if((passes >> level) & 1)
+            {
+                node = jumps[level][node];
+            }
+        }
+        return node;
+    }
+
+    Path path;
+    std::vector<Node> names;
+    std::unordered_map<Node, NodeId> ids;
+    std::array<std::vector<NodeId>, NEIGHBOURS> neighbourIds;
+    std::vector<std::vector<NodeId>> jumps;
+};
 }
 
 #endif
@@ -6,12 +6,14 @@
 #include <ranges>
 #include <stdexcept>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "../task.hpp"
 
 int main()
 {
-    task::lval sum = 0;
+    std::vector<task::input::ValCol> sequences;
     for(const auto lineView :
         std::ranges::subrange(std::istreambuf_iterator<char>{std::cin},
                               std::istreambuf_iterator<char>{}) |
@@ -23,15 +25,21 @@ int main()
         {
             continue;
         }
-        const auto maybeValues = task::input::parseValues(line);
+        auto maybeValues = task::input::parseValues(line);
         if(!maybeValues)
         {
             throw std::runtime_error(
                 std::format("input parse failed: {}", maybeValues.error()));
         }
-        const auto res = task::predictPrevious(*maybeValues);
-        sum += res;
+        sequences.push_back(std::move(*maybeValues));
     }
-    std::cout << sum << '\n';
+    const auto maybeSum =
+        task::sumPredictions(sequences, 1, task::Direction::BACKWARD);
+    if(!maybeSum)
+    {
+        throw std::runtime_error(
+            std::format("extrapolation failed: {}", maybeSum.error()));
+    }
+    std::cout << *maybeSum << '\n';
     return 0;
 }
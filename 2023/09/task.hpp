@@ -2,12 +2,18 @@
 #define TASK_HPP
 
 #include <algorithm>
+#include <cassert>
+#include <concepts>
+#include <cstddef>
 #include <expected>
 #include <format>
-#include <functional>
+#include <limits>
+#include <optional>
 #include <ranges>
 #include <string>
 #include <string_view>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "../base.hpp"
@@ -44,35 +50,267 @@ namespace input
     }
 }
 
-template<std::ranges::random_access_range R>
-task::val predictNext(const R &values)
+enum class Direction
 {
-    std::vector<task::val> diffs(std::ranges::begin(values),
-                                 std::ranges::end(values));
-    std::vector<task::val> hist;
-    while(!diffs.empty())
+    FORWARD,
+    BACKWARD,
+};
+
+namespace detail
+{
+    using wide = __int128;
+    using uwide = unsigned __int128;
+
+    constexpr uwide WIDE_MAX = static_cast<uwide>(-1) >> 1;
+
+    // C(n, k) without intermediate results larger than the final one.
+    constexpr std::optional<uwide> binomial(const uwide n, uwide k)
+    {
+        if(k > n)
+        {
+            return 0;
+        }
+        k = std::min(k, n - k);
+        uwide result = 1;
+        for(uwide i = 1; i <= k; ++i)
+        {
+            const auto factor = n - k + i;
+            auto g = result;
+            auto divisor = i;
+            while(divisor != 0)
+            {
+                g = std::exchange(divisor, g % divisor);
+            }
+            const auto reduced = result / g;
+            const auto multiplier = factor / (i / g);
+            if(multiplier != 0 && reduced > WIDE_MAX / multiplier)
+            {
+                return std::nullopt;
+            }
+            result = reduced * multiplier;
+        }
+        return result;
+    }
+}
+
+// Newton forward form of the polynomial through the values of a sequence:
+// the value `steps` places after the last one is a fixed linear combination
+// of the values, so the coefficients are prepared once per sequence length
+// and every prediction is one dot product.
+class Extrapolator
+{
+public:
+    explicit Extrapolator(std::vector<detail::wide> coefficients)
+        : wideCoefficients(std::move(coefficients))
+    {
+        detail::uwide magnitude = 0;
+        for(const auto coefficient : wideCoefficients)
+        {
+            if(__builtin_add_overflow(
+                   magnitude,
+                   static_cast<detail::uwide>(coefficient < 0 ? -coefficient
+                                                              : coefficient),
+                   &magnitude))
+            {
+                // far too large for lval, only the checked path is left
+                return;
+            }
+        }
+        // the sum of |c * v| fits lval for any v of type val
+        if(magnitude <= static_cast<detail::uwide>(
+                            std::numeric_limits<lval>::max()) >>
+                            std::numeric_limits<val>::digits)
+        {
+            narrowCoefficients.assign(wideCoefficients.begin(),
+                                      wideCoefficients.end());
+        }
+    }
+
+    [[nodiscard]] std::size_t size() const
+    {
+        return wideCoefficients.size();
+    }
+
+    template<std::ranges::random_access_range R>
+    requires std::convertible_to<std::ranges::range_value_t<R>, val>
+    std::optional<lval> operator()(const R &values) const
+    {
+        assert(std::ranges::size(values) == size());
+        if(!narrowCoefficients.empty())
+        {
+            lval result = 0;
+            for(std::size_t i = 0; i < narrowCoefficients.size(); ++i)
+            {
+                result += narrowCoefficients[i] *
+                          static_cast<lval>(std::ranges::begin(values)[i]);
+            }
+            return result;
+        }
+        detail::wide result = 0;
+        for(std::size_t i = 0; i < wideCoefficients.size(); ++i)
+        {
+            detail::wide term = 0;
+            if(__builtin_mul_overflow(
+                   wideCoefficients[i],
+                   static_cast<detail::wide>(std::ranges::begin(values)[i]),
+                   &term) ||
+               __builtin_add_overflow(result, term, &result))
+            {
+                return std::nullopt;
+            }
+        }
+        if(result < std::numeric_limits<lval>::min() ||
+           result > std::numeric_limits<lval>::max())
+        {
+            return std::nullopt;
+        }
+        return static_cast<lval>(result);
+    }
+
+private:
+    std::vector<detail::wide> wideCoefficients;
+    std::vector<lval> narrowCoefficients;
+};
+
+// The Lagrange basis at m = length - 1 + steps of the points 0..length-1
+// is (-1)^(length-1-i) * C(m, i) * C(m-i-1, length-1-i), the backward
+// direction uses the same weights on the reversed sequence.
+inline std::expected<Extrapolator, std::string> prepareExtrapolator(
+    const std::size_t length, const std::size_t steps = 1,
+    const Direction direction = Direction::FORWARD)
+{
+    if(steps == 0)
     {
-        hist.push_back(diffs.back());
-        bool zeros = true;
-        for(std::size_t i = 0; i + 1 < diffs.size(); ++i)
+        return std::unexpected("no extrapolation steps");
+    }
+    std::vector<detail::wide> coefficients(length);
+    const auto m = static_cast<detail::uwide>(length) - 1 + steps;
+    for(std::size_t i = 0; i < length; ++i)
+    {
+        const auto maybeLeft = detail::binomial(m, i);
+        const auto maybeRight = detail::binomial(m - i - 1, length - 1 - i);
+        if(!maybeLeft || !maybeRight ||
+           (*maybeRight != 0 && *maybeLeft > detail::WIDE_MAX / *maybeRight))
+        {
+            return std::unexpected("extrapolation coefficient overflow");
+        }
+        const auto magnitude = static_cast<detail::wide>(*maybeLeft *
+                                                         *maybeRight);
+        auto &coefficient =
+            coefficients[direction == Direction::FORWARD ? i
+                                                         : length - 1 - i];
+        coefficient = ((length - 1 - i) % 2 == 0 ? magnitude : -magnitude);
+    }
+    return Extrapolator(std::move(coefficients));
+}
+
+namespace detail
+{
+    // Extends the table of differences of `values` by `steps`, exact as long
+    // as no difference overflows. Long sequences have Lagrange weights too
+    // large to multiply with the values, while their differences usually
+    // vanish after a few rows.
+    template<std::ranges::random_access_range R>
+    std::optional<lval> extendDifferences(const R &values,
+                                          const std::size_t steps,
+                                          const Direction direction)
+    {
+        std::vector<wide> diffs(std::ranges::begin(values),
+                                std::ranges::end(values));
+        if(direction == Direction::BACKWARD)
+        {
+            std::ranges::reverse(diffs);
+        }
+        // last value of every row, the deepest row being constant
+        std::vector<wide> tails;
+        while(!diffs.empty())
+        {
+            tails.push_back(diffs.back());
+            bool zeros = true;
+            for(std::size_t i = 0; i + 1 < diffs.size(); ++i)
+            {
+                if(__builtin_sub_overflow(diffs[i + 1], diffs[i], &diffs[i]))
+                {
+                    return std::nullopt;
+                }
+                zeros = (zeros && diffs[i] == 0);
+            }
+            if(zeros)
+            {
+                break;
+            }
+            diffs.pop_back();
+        }
+        for(std::size_t step = 0; step < steps; ++step)
         {
-            diffs[i] = diffs[i + 1] - diffs[i];
-            zeros = (zeros && diffs[i] == 0);
+            for(auto row = tails.size(); row > 1; --row)
+            {
+                if(__builtin_add_overflow(tails[row - 2], tails[row - 1],
+                                          &tails[row - 2]))
+                {
+                    return std::nullopt;
+                }
+            }
         }
-        if(zeros)
+        if(tails.empty())
         {
-            break;
+            return 0;
         }
-        diffs.pop_back();
+        if(tails.front() < std::numeric_limits<lval>::min() ||
+           tails.front() > std::numeric_limits<lval>::max())
+        {
+            return std::nullopt;
+        }
+        return static_cast<lval>(tails.front());
     }
-    return std::ranges::fold_left(hist, static_cast<task::val>(0),
-                                  std::plus<>{});
 }
 
-template<std::ranges::random_access_range R>
-task::val predictPrevious(const R &values)
+// Predicts all the sequences with one Extrapolator per distinct length. A
+// sequence whose weights or dot product overflow is extended through its
+// table of differences instead.
+template<std::ranges::input_range R>
+requires std::ranges::random_access_range<std::ranges::range_value_t<R>>
+std::expected<lval, std::string> sumPredictions(
+    const R &sequences, const std::size_t steps = 1,
+    const Direction direction = Direction::FORWARD)
 {
-    return predictNext(std::ranges::views::reverse(values));
+    if(steps == 0)
+    {
+        return std::unexpected("no extrapolation steps");
+    }
+    // std::nullopt for the lengths whose weights overflow
+    std::unordered_map<std::size_t, std::optional<Extrapolator>>
+        extrapolators;
+    lval sum = 0;
+    for(const auto &values : sequences)
+    {
+        const auto length = std::ranges::size(values);
+        auto iter = extrapolators.find(length);
+        if(iter == end(extrapolators))
+        {
+            auto maybeExtrapolator =
+                prepareExtrapolator(length, steps, direction);
+            iter = extrapolators
+                       .emplace(length, (maybeExtrapolator
+                                             ? std::optional(std::move(
+                                                   *maybeExtrapolator))
+                                             : std::nullopt))
+                       .first;
+        }
+        auto maybePrediction =
+            (iter->second ? (*iter->second)(values) : std::nullopt);
+        if(!maybePrediction)
+        {
+            maybePrediction =
+                detail::extendDifferences(values, steps, direction);
+        }
+        if(!maybePrediction ||
+           __builtin_add_overflow(sum, *maybePrediction, &sum))
+        {
+            return std::unexpected("prediction overflow");
+        }
+    }
+    return sum;
 }
 }
 
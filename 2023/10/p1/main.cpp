@@ -6,19 +6,18 @@
 
 int main()
 {
-    const auto maybeAnimalBoard = task::input::parseAnimalBoard(std::cin);
-    if(!maybeAnimalBoard)
+    const auto maybeGrid = task::input::parseAnimalBoard(std::cin);
+    if(!maybeGrid)
     {
         throw std::runtime_error(
-            std::format("input parsing failed: {}", maybeAnimalBoard.error()));
+            std::format("input parsing failed: {}", maybeGrid.error()));
     }
-    const auto loopSteps =
-        task::findLoop(maybeAnimalBoard->board, maybeAnimalBoard->start);
-    if(!loopSteps)
+    const auto maybeLoop = task::findLoop(*maybeGrid);
+    if(!maybeLoop)
     {
         throw std::runtime_error("no animal loop found");
     }
-    const auto farthestSteps = loopSteps->size() / 2;
+    const auto farthestSteps = maybeLoop->length / 2;
     std::cout << farthestSteps << '\n';
     return 0;
 }
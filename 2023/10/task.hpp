@@ -1,25 +1,19 @@
 #ifndef TASK_HPP
 #define TASK_HPP
 
-#include <algorithm>
 #include <array>
 #include <cstddef>
+#include <cstdint>
 #include <expected>
 #include <istream>
 #include <optional>
-#include <ranges>
 #include <string>
-#include <tuple>
 #include <utility>
 #include <vector>
 
-#include "../geom.hpp"
-#include "../geom_plane.hpp"
-#include "../matrix.hpp"
-
 namespace task
 {
-enum class Cell
+enum class Cell : std::uint8_t
 {
     EMPTY = 0,
     HORIZONTAL,
@@ -28,28 +22,41 @@ enum class Cell
     ROT_UP_LEFT,
     ROT_DOWN_LEFT,
     ROT_DOWN_RIGHT,
+    START,
+};
+
+enum class Dir : std::uint8_t
+{
+    UP = 0,
+    RIGHT,
+    DOWN,
+    LEFT,
+    NONE,
 };
 
-using Pos = geom::Pos;
-using Board = numutil::Matrix<Cell>;
 using Size = std::size_t;
+using lval = long long int;
 
-struct PathEntry
+constexpr std::size_t CELL_KINDS = std::to_underlying(Cell::START) + 1;
+constexpr std::size_t DIRS = std::to_underlying(Dir::NONE);
+
+// Row major cells surrounded by a border of empty ones, so that no step of
+// a walk can leave the grid.
+struct PipeGrid
 {
-    Pos pos{};
-    Pos dir{};
+    std::vector<Cell> cells;
+    Size width{};
+    Size start{};
 };
 
-using Path = std::vector<PathEntry>;
+struct Loop
+{
+    Size length{};
+    Size inside{};
+};
 
 namespace input
 {
-    struct AnimalBoard
-    {
-        Board board{};
-        Pos start{};
-    };
-
     namespace detail
     {
         constexpr std::optional<Cell> parseCell(char c)
@@ -70,13 +77,15 @@ namespace input
                 return Cell::ROT_DOWN_LEFT;
             case 'F':
                 return Cell::ROT_DOWN_RIGHT;
+            case 'S':
+                return Cell::START;
             default:
                 return std::nullopt;
             }
         }
     }
 
-    inline std::expected<AnimalBoard, std::string> parseAnimalBoard(
+    inline std::expected<PipeGrid, std::string> parseAnimalBoard(
         std::istream &stream)
     {
         std::vector<std::string> rows;
@@ -98,153 +107,115 @@ namespace input
         {
             return std::unexpected("no start position");
         }
-        std::optional<Pos> start;
-        Board board(rows.size(), rows.front().size());
+        PipeGrid grid;
+        grid.width = rows.front().size() + 2;
+        grid.cells.assign(grid.width * (rows.size() + 2), Cell::EMPTY);
+        std::optional<Size> start;
         for(std::size_t rowIdx = 0; rowIdx < rows.size(); ++rowIdx)
         {
             const auto &row = rows[rowIdx];
             for(std::size_t colIdx = 0; colIdx < row.size(); ++colIdx)
             {
-                const auto value = row[colIdx];
-                Cell cell{};
-                if(value != 'S')
+                const auto maybeCell = detail::parseCell(row[colIdx]);
+                if(!maybeCell)
                 {
-                    const auto maybeCell = detail::parseCell(value);
-                    if(!maybeCell)
-                    {
-                        return std::unexpected("invalid board cell");
-                    }
-                    cell = *maybeCell;
+                    return std::unexpected("invalid board cell");
                 }
-                else
+                const auto idx = (rowIdx + 1) * grid.width + colIdx + 1;
+                if(*maybeCell == Cell::START)
                 {
-                    start =
-                        Pos{static_cast<int>(rowIdx), static_cast<int>(colIdx)};
-                    cell = Cell::EMPTY;
+                    start = idx;
                 }
-                board.ix(rowIdx, colIdx) = cell;
+                grid.cells[idx] = *maybeCell;
             }
         }
         if(!start)
         {
             return std::unexpected("no start position");
         }
-        return AnimalBoard{std::move(board), *start};
+        grid.start = *start;
+        return grid;
     }
 }
 
 namespace detail
 {
-    using TransformMatrix = numutil::Matrix<int>;
-    constexpr std::size_t TRANSFORM_SIZE = 2;
+    using Transitions = std::array<std::array<Dir, DIRS>, CELL_KINDS>;
 
-    inline TransformMatrix prepareTransform(
-        const std::array<std::array<int, TRANSFORM_SIZE>, TRANSFORM_SIZE>
-            &values)
+    constexpr Dir opposite(const Dir dir)
     {
-        TransformMatrix result(values.size(), values.front().size());
-        for(std::size_t r = 0; r < values.size(); ++r)
+        return static_cast<Dir>((std::to_underlying(dir) + 2) % DIRS);
+    }
+
+    // The direction of leaving a cell entered moving in a direction, NONE
+    // when the pipe has no opening towards the entry.
+    constexpr Transitions TRANSITIONS = [] {
+        constexpr std::array<std::pair<Dir, Dir>, CELL_KINDS> OPENINGS{{
+            {Dir::NONE, Dir::NONE},
+            {Dir::LEFT, Dir::RIGHT},
+            {Dir::UP, Dir::DOWN},
+            {Dir::UP, Dir::RIGHT},
+            {Dir::UP, Dir::LEFT},
+            {Dir::DOWN, Dir::LEFT},
+            {Dir::DOWN, Dir::RIGHT},
+            {Dir::NONE, Dir::NONE},
+        }};
+        Transitions result{};
+        for(std::size_t cell = 0; cell < CELL_KINDS; ++cell)
         {
-            for(std::size_t c = 0; c < values.size(); ++c)
+            const auto [first, second] = OPENINGS[cell];
+            for(std::size_t dir = 0; dir < DIRS; ++dir)
             {
-                result.ix(r, c) = values[r][c];
+                const auto entry = opposite(static_cast<Dir>(dir));
+                result[cell][dir] = (entry == first    ? second
+                                     : entry == second ? first
+                                                       : Dir::NONE);
             }
         }
         return result;
-    }
+    }();
 
-    inline bool check(const Pos &pos, const TransformMatrix &transform)
-    {
-        return (pos.r == transform.ix(0, 0) || pos.c == transform.ix(0, 1)) ||
-               (pos.r == transform.ix(1, 0) || pos.c == transform.ix(1, 1));
-    }
-
-    inline Pos transform(const Pos &pos, const TransformMatrix &transform)
-    {
-        return Pos{
-            pos.r * transform.ix(0, 0) + pos.c * transform.ix(0, 1),
-            pos.r * transform.ix(1, 0) + pos.c * transform.ix(1, 1),
-        };
-    }
+    constexpr std::array<int, DIRS> ROW_STEPS{-1, 0, 1, 0};
+    constexpr std::array<int, DIRS> COL_STEPS{0, 1, 0, -1};
 }
 
-inline std::optional<Path> findLoop(const Board &board, const Pos &pos)
+// Walks the loop through the start in one pass: the shoelace sum gives its
+// area and Pick's theorem the number of the enclosed tiles.
+inline std::optional<Loop> findLoop(const PipeGrid &grid)
 {
-    using Operation =
-        std::tuple<detail::TransformMatrix, detail::TransformMatrix>;
-
-    constexpr int DIRS = 4;
-
-    const auto directTransform = detail::prepareTransform({{{1, 0}, {0, 1}}});
-    const auto rotateTransform = detail::prepareTransform({{{0, 1}, {1, 0}}});
-    const auto invRotateTransform =
-        detail::prepareTransform({{{0, -1}, {-1, 0}}});
-    std::array<Operation, std::to_underlying(Cell::ROT_DOWN_RIGHT) + 1>
-        operations{
-            Operation{detail::prepareTransform({0, 0, 0, 0}),
-                      detail::prepareTransform({0, 0, 0, 0})},
-            Operation{detail::prepareTransform({0, 1, 0, -1}), directTransform},
-            Operation{detail::prepareTransform({1, 0, -1, 0}), directTransform},
-            Operation{detail::prepareTransform({1, -1, 0, 0}), rotateTransform},
-            Operation{detail::prepareTransform({1, 1, 0, 0}),
-                      invRotateTransform},
-            Operation{detail::prepareTransform({-1, 1, 0, 0}), rotateTransform},
-            Operation{detail::prepareTransform({1, -1, 0, 0}),
-                      invRotateTransform},
-        };
-    const auto checkStep = [&](const auto &pos, const auto &dir) {
-        const auto next = pos + dir;
-        if(next.r >= 0 && static_cast<std::size_t>(next.r) < board.rows() &&
-           next.c >= 0 && static_cast<std::size_t>(next.c) < board.columns())
-        {
-            return detail::check(
-                dir,
-                std::get<0>(
-                    operations[std::to_underlying(board.ix(next.r, next.c))]));
-        }
-        return false;
-    };
-    const auto follow = [&](const auto &pos, auto dir) -> std::optional<Path> {
-        constexpr Pos INVALID_DIR{0, 0};
-        auto cur = pos;
-        Path steps;
-        while(dir != INVALID_DIR)
+    const auto width = static_cast<std::ptrdiff_t>(grid.width);
+    const std::array<std::ptrdiff_t, DIRS> idxSteps{-width, 1, width, -1};
+    for(std::size_t initDir = 0; initDir < DIRS; ++initDir)
+    {
+        auto dir = static_cast<Dir>(initDir);
+        auto idx = grid.start;
+        lval row = 0;
+        lval col = 0;
+        lval twiceArea = 0;
+        Size length = 0;
+        while(dir != Dir::NONE)
         {
-            if(checkStep(cur, dir))
+            const auto d = std::to_underlying(dir);
+            idx += idxSteps[d];
+            const auto nextRow = row + detail::ROW_STEPS[d];
+            const auto nextCol = col + detail::COL_STEPS[d];
+            twiceArea += row * nextCol - nextRow * col;
+            row = nextRow;
+            col = nextCol;
+            ++length;
+            if(idx == grid.start)
             {
-                steps.emplace_back(cur, dir);
-                cur = cur + dir;
-                if(cur == pos)
-                {
-                    break;
-                }
-                dir = detail::transform(
-                    dir, std::get<1>(operations[std::to_underlying(
-                             board.ix(cur.r, cur.c))]));
-            }
-            else
-            {
-                return std::nullopt;
+                const auto area = (twiceArea < 0 ? -twiceArea : twiceArea);
+                return Loop{
+                    length,
+                    static_cast<Size>(area / 2) + 1 - length / 2,
+                };
             }
-        }
-        return dir != INVALID_DIR ? std::make_optional(std::move(steps))
-                                  : std::nullopt;
-    };
-    for(int i = 0; i < DIRS; ++i)
-    {
-        const auto coef = ((i / 2) * 2 - 1);
-        const auto dirRow = coef * (i % 2);
-        const auto dirCol = coef * (1 - i % 2);
-        const Pos dir{dirRow, dirCol};
-        if(const auto maybeSteps = follow(pos, dir))
-        {
-            return *maybeSteps;
+            dir = detail::TRANSITIONS[std::to_underlying(grid.cells[idx])][d];
         }
     }
     return std::nullopt;
 }
-
-using geom::calculateInside;
 }
 
 #endif
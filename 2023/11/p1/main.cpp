@@ -1,6 +1,4 @@
-#include <algorithm>
 #include <format>
-#include <functional>
 #include <iostream>
 #include <stdexcept>
 
@@ -15,9 +13,6 @@ int main()
             std::format("input parsing failed: {}", maybeBoard.error()));
     }
     constexpr task::uval expansion = 2;
-    const auto distances = task::galaxyDistances(*maybeBoard, expansion);
-    std::cout << std::ranges::fold_left(distances, static_cast<task::uval>(0),
-                                        std::plus<>{})
-              << '\n';
+    std::cout << task::galaxyDistanceSum(*maybeBoard).total(expansion) << '\n';
     return 0;
 }
@@ -1,6 +1,4 @@
-#include <algorithm>
 #include <format>
-#include <functional>
 #include <iostream>
 #include <stdexcept>
 
@@ -14,12 +12,10 @@ int main()
         throw std::runtime_error(
             std::format("input parsing failed: {}", maybeBoard.error()));
     }
+    const auto distanceSum = task::galaxyDistanceSum(*maybeBoard);
     for(const auto expansion : {10, 100, 1000000})
     {
-        const auto distances = task::galaxyDistances(*maybeBoard, expansion);
-        std::cout << std::ranges::fold_left(
-                         distances, static_cast<task::uval>(0), std::plus<>{})
-                  << '\n';
+        std::cout << distanceSum.total(expansion) << '\n';
     }
     return 0;
 }
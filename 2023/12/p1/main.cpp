@@ -5,12 +5,15 @@
 #include <ranges>
 #include <stdexcept>
 #include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
 
 #include "../task.hpp"
 
 int main()
 {
-    task::ulval sum = 0;
+    std::vector<std::tuple<task::Row, task::CountCol>> rows;
     for(const auto lineView :
         std::ranges::subrange(std::istreambuf_iterator<char>{std::cin},
                               std::istreambuf_iterator<char>{}) |
@@ -22,16 +25,14 @@ int main()
         {
             continue;
         }
-        const auto maybeInputRow = task::input::parseInputRow(line);
+        auto maybeInputRow = task::input::parseInputRow(line);
         if(!maybeInputRow)
         {
             throw std::runtime_error(std::format("input row parsing failed: {}",
                                                  maybeInputRow.error()));
         }
-        const auto &[row, counts] = *maybeInputRow;
-        const auto res = task::solve(row, counts);
-        sum += res;
+        rows.push_back(std::move(*maybeInputRow));
     }
-    std::cout << sum << '\n';
+    std::cout << task::sumArrangements(rows) << '\n';
     return 0;
 }
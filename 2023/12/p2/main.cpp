@@ -5,12 +5,15 @@
 #include <ranges>
 #include <stdexcept>
 #include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
 
 #include "../task.hpp"
 
 int main()
 {
-    task::ulval sum = 0;
+    std::vector<std::tuple<task::Row, task::CountCol>> rows;
     for(const auto lineView :
         std::ranges::subrange(std::istreambuf_iterator<char>{std::cin},
                               std::istreambuf_iterator<char>{}) |
@@ -22,33 +25,15 @@ int main()
         {
             continue;
         }
-        const auto maybeInputRow = task::input::parseInputRow(line);
+        auto maybeInputRow = task::input::parseInputRow(line);
         if(!maybeInputRow)
         {
             throw std::runtime_error(std::format("input row parsing failed: {}",
                                                  maybeInputRow.error()));
         }
-        constexpr task::uval repeats = 5;
-        const auto &[row, counts] = *maybeInputRow;
-        task::Row actualRow;
-        task::CountCol actualCounts;
-        bool first = true;
-        for(task::uval i = 0; i < repeats; ++i)
-        {
-            if(!first)
-            {
-                actualRow.push_back(task::Cell::UNKNOWN);
-            }
-            else
-            {
-                first = false;
-            }
-            actualRow.insert(end(actualRow), begin(row), end(row));
-            actualCounts.insert(end(actualCounts), begin(counts), end(counts));
-        }
-        const auto res = task::solve(actualRow, actualCounts);
-        sum += res;
+        rows.push_back(std::move(*maybeInputRow));
     }
-    std::cout << sum << '\n';
+    constexpr task::uval repeats = 5;
+    std::cout << task::sumArrangements(rows, repeats) << '\n';
     return 0;
 }
@@ -4,24 +4,21 @@
 #include <algorithm>
 #include <cassert>
 #include <cstddef>
-#include <deque>
 #include <expected>
 #include <format>
 #include <istream>
 #include <iterator>
-#include <map>
-#include <optional>
 #include <ostream>
 #include <ranges>
 #include <span>
 #include <string>
 #include <string_view>
 #include <tuple>
-#include <type_traits>
 #include <utility>
 #include <vector>
 
 #include "../base.hpp"
+#include "../parallel.hpp"
 
 namespace task
 {
@@ -106,7 +103,7 @@ namespace input
                                      std::ranges::end(numberView)));
                 if(!maybeVal)
                 {
-                    std::unexpected("invalid count number");
+                    return std::unexpected("invalid count number");
                 }
                 result.push_back(*maybeVal);
             }
@@ -138,176 +135,108 @@ namespace input
     }
 }
 
-namespace detail
+// Counts the arrangements with a dynamic program over (group, position):
+// ways[group][pos] is the number of arrangements of the groups from `group`
+// on within the cells from `pos` on. Whether a run of damaged springs fits
+// at a position is checked in O(1) with the prefix counts of operational
+// cells. The buffers are kept between rows, so counting a row does not
+// allocate once they are large enough.
+//
+// The cost is O(cells * groups), which grows with the square of an unfold
+// factor. Groups are not tied to the copies of an unfolded row, a copy may
+// take any number of them, so the table can't be reduced to a fixed state
+// carried from copy to copy.
+class ArrangementCounter
 {
-    struct CandKey
+public:
+    ulval operator()(std::span<const Cell> row, std::span<const uval> counts)
     {
-        uval candSize{};
-        uval frontCount{};
-        uval countSize{};
-
-        friend auto operator<=>(const CandKey &left,
-                                const CandKey &right) = default;
-    };
-}
-
-inline ulval solve(const Row &row, const CountCol &counts)
-{
-    struct Cand
-    {
-        Cell cell{};
-        uval count{};
-    };
-    std::deque<Cand> cands;
-    {
-        Cell prev = Cell::UNKNOWN;
-        uval count = 0;
-        const auto handleChunk = [&] {
-            if(count)
-            {
-                cands.emplace_back(prev, count);
-            }
-        };
-        for(const auto val : row)
-        {
-            if(val != prev)
-            {
-                handleChunk();
-                prev = val;
-                count = 1;
-            }
-            else
-            {
-                ++count;
-            }
-        }
-        handleChunk();
-    }
-
-    const auto decrementCand = [](auto &cands, const uval count) {
-        assert(!cands.empty());
-        auto &cur = cands.front().count;
-        assert(cur >= count);
-        cur -= count;
-        if(cur == 0)
+        const auto size = row.size();
+        const auto stride = size + 1;
+        operational.assign(stride, 0);
+        damaged.assign(stride, 0);
+        for(std::size_t pos = 0; pos < size; ++pos)
         {
-            cands.pop_front();
+            operational[pos + 1] =
+                operational[pos] + (row[pos] == Cell::OPERATIONAL);
+            damaged[pos + 1] = damaged[pos] + (row[pos] == Cell::DAMAGED);
         }
-    };
-    std::map<detail::CandKey, ulval> mem;
-    const auto traverse = [&](auto traverse, auto &&cands,
-                              std::span<const uval> counts) -> ulval {
-        if(counts.empty() && cands.empty())
+        ways.assign(stride * (counts.size() + 1), 0);
+        for(std::size_t pos = 0; pos <= size; ++pos)
         {
-            return 1;
+            ways[counts.size() * stride + pos] =
+                (damaged[size] == damaged[pos]);
         }
-        if(cands.empty())
+        for(auto group = counts.size(); group > 0; --group)
         {
-            return 0;
-        }
-        const detail::CandKey candKey{
-            static_cast<uval>(cands.size()),
-            cands.front().count,
-            static_cast<uval>(counts.size()),
-        };
-        if(const auto iter = mem.find(candKey); iter != end(mem))
-        {
-            return iter->second;
-        }
-        const auto res = [&] {
-            if(cands.front().cell == Cell::OPERATIONAL)
-            {
-                auto nxt = std::forward<decltype(cands)>(cands);
-                nxt.pop_front();
-                return traverse(traverse, std::move(nxt), counts);
-            }
-            if(counts.empty())
-            {
-                if(cands.front().cell == Cell::UNKNOWN)
-                {
-                    auto nxt = std::forward<decltype(cands)>(cands);
-                    nxt.pop_front();
-                    return traverse(traverse, std::move(nxt), counts);
-                }
-                return static_cast<ulval>(0);
-            }
-            const auto takeCount = [&](const auto &cands, auto count)
-                -> std::optional<
-                    std::tuple<std::decay_t<decltype(cands)>, bool>> {
-                auto result = cands;
-                while(count > 0 && !result.empty())
-                {
-                    if(result.front().cell == Cell::OPERATIONAL)
-                    {
-                        return std::nullopt;
-                    }
-                    if(result.front().cell == Cell::DAMAGED)
-                    {
-                        if(result.front().count > count)
-                        {
-                            return std::nullopt;
-                        }
-                        count -= result.front().count;
-                        decrementCand(result, result.front().count);
-                    }
-                    else
-                    {
-                        const auto diff = std::min(count, result.front().count);
-                        count -= diff;
-                        decrementCand(result, diff);
-                    }
-                }
-                if(count == 0)
-                {
-                    bool add = false;
-                    if(!result.empty())
-                    {
-                        if(result.front().cell == Cell::DAMAGED)
-                        {
-                            return std::nullopt;
-                        }
-                        if(result.front().cell == Cell::UNKNOWN)
-                        {
-                            decrementCand(result, 1);
-                            add = true;
-                        }
-                    }
-                    return std::make_tuple(std::move(result), add);
-                }
-                return std::nullopt;
-            };
-            ulval result = 0;
-            if(cands.front().cell == Cell::UNKNOWN)
+            const auto count = counts[group - 1];
+            auto *cur = &ways[(group - 1) * stride];
+            const auto *next = &ways[group * stride];
+            for(auto pos = size; pos > 0; --pos)
             {
-                if(auto maybeTake = takeCount(cands, counts.front()))
+                const auto idx = pos - 1;
+                ulval result = (row[idx] != Cell::DAMAGED ? cur[pos] : 0);
+                if(const auto end = idx + count;
+                   end <= size && operational[end] == operational[idx] &&
+                   (end == size || row[end] != Cell::DAMAGED))
                 {
-                    auto &[maybeNxt, add] = *maybeTake;
-                    result += traverse(traverse, std::move(maybeNxt),
-                                       counts.subspan(1));
-                }
-                {
-                    auto nxt = std::forward<decltype(cands)>(cands);
-                    decrementCand(nxt, 1);
-                    result += traverse(traverse, std::move(nxt), counts);
+                    result += next[std::min(end + 1, size)];
                 }
+                cur[idx] = result;
             }
-            else if(cands.front().cell == Cell::DAMAGED)
+        }
+        return ways[0];
+    }
+
+private:
+    std::vector<uval> operational;
+    std::vector<uval> damaged;
+    std::vector<ulval> ways;
+};
+
+inline ulval solve(const Row &row, const CountCol &counts)
+{
+    return ArrangementCounter{}(row, counts);
+}
+
+// The row repeated `repeats` times joined by unknown cells, the counts
+// repeated as well.
+inline void unfold(const Row &row, const CountCol &counts, const uval repeats,
+                   Row &unfoldedRow, CountCol &unfoldedCounts)
+{
+    unfoldedRow.clear();
+    unfoldedCounts.clear();
+    for(uval i = 0; i < repeats; ++i)
+    {
+        if(i != 0)
+        {
+            unfoldedRow.push_back(Cell::UNKNOWN);
+        }
+        unfoldedRow.insert(end(unfoldedRow), begin(row), end(row));
+        unfoldedCounts.insert(end(unfoldedCounts), begin(counts), end(counts));
+    }
+}
+
+// Sum of the arrangements of the unfolded rows, computed in parallel with
+// one counter per worker.
+inline ulval sumArrangements(const std::vector<std::tuple<Row, CountCol>> &rows,
+                             const uval repeats = 1)
+{
+    return xutil::parallelReduce(
+        rows.size(), ulval{},
+        [&](const std::size_t begin, const std::size_t end) {
+            ArrangementCounter counter;
+            Row unfoldedRow;
+            CountCol unfoldedCounts;
+            ulval sum = 0;
+            for(auto idx = begin; idx < end; ++idx)
             {
-                if(auto maybeTake = takeCount(cands, counts.front()))
-                {
-                    auto &[maybeNxt, add] = *maybeTake;
-                    result += traverse(traverse, std::move(maybeNxt),
-                                       counts.subspan(1));
-                }
+                const auto &[row, counts] = rows[idx];
+                unfold(row, counts, repeats, unfoldedRow, unfoldedCounts);
+                sum += counter(unfoldedRow, unfoldedCounts);
             }
-            return result;
-        }();
-        mem.emplace(candKey, res);
-        return res;
-    };
-    return traverse(traverse, cands,
-                    std::span<const uval>{std::ranges::begin(counts),
-                                          std::ranges::end(counts)});
+            return sum;
+        });
 }
 }
 
@@ -2,25 +2,36 @@
 #define TASK_HPP
 
 #include <algorithm>
+#include <bit>
 #include <concepts>
 #include <cstddef>
+#include <cstdint>
 #include <expected>
-#include <functional>
+#include <format>
 #include <optional>
 #include <ranges>
 #include <span>
 #include <string>
-#include <tuple>
+#include <string_view>
 #include <type_traits>
 #include <utility>
 #include <vector>
 
-#include "../matrix.hpp"
+#include "../parallel.hpp"
 
 namespace task
 {
-using Board = numutil::Matrix<int>;
 using uval = std::size_t;
+using Mask = std::uint64_t;
+
+constexpr std::size_t MAX_SIZE = 64;
+
+// Every row and every column as a bit mask of its rocks.
+struct Pattern
+{
+    std::vector<Mask> rows;
+    std::vector<Mask> cols;
+};
 
 enum class Dir
 {
@@ -36,9 +47,33 @@ struct Reflection
 
 namespace input
 {
-    inline std::expected<Board, std::string> parseBoard(std::string_view str)
+    // The patterns separated by empty lines.
+    inline std::vector<std::string_view> splitPatterns(std::string_view str)
     {
-        std::vector<std::string> rows;
+        std::vector<std::string_view> result;
+        while(!str.empty())
+        {
+            auto end = str.find("\n\n");
+            end = (end == std::string_view::npos ? str.size() : end + 1);
+            if(str.substr(0, end).find_first_not_of('\n') !=
+               std::string_view::npos)
+            {
+                result.push_back(str.substr(0, end));
+            }
+            str.remove_prefix(end);
+            while(str.starts_with('\n'))
+            {
+                str.remove_prefix(1);
+            }
+        }
+        return result;
+    }
+
+    // Fills the row and the column masks in one pass over the pattern.
+    inline std::expected<Pattern, std::string> parsePattern(
+        std::string_view str)
+    {
+        Pattern pattern;
         for(const auto rowView : str | std::views::split('\n'))
         {
             const auto size = std::ranges::size(rowView);
@@ -46,24 +81,36 @@ namespace input
             {
                 continue;
             }
-            if(!rows.empty() && rows.back().size() != size)
+            if(!pattern.rows.empty() && pattern.cols.size() != size)
             {
                 return std::unexpected("row lengths mismatch");
             }
-            rows.emplace_back(std::ranges::begin(rowView),
-                              std::ranges::end(rowView));
-        }
-        Board board(rows.size(), rows.front().size());
-        for(std::size_t rowIdx = 0; rowIdx < rows.size(); ++rowIdx)
-        {
-            const auto &row = rows[rowIdx];
-            for(std::size_t colIdx = 0; colIdx < row.size(); ++colIdx)
+            if(size > MAX_SIZE || pattern.rows.size() == MAX_SIZE)
             {
-                const auto value = row[colIdx];
-                board.ix(rowIdx, colIdx) = (value == '#');
+                return std::unexpected("pattern too large");
             }
+            pattern.cols.resize(size);
+            const auto rowBit = Mask{1} << pattern.rows.size();
+            auto &row = pattern.rows.emplace_back();
+            for(std::size_t col = 0; const auto value : rowView)
+            {
+                if(value == '#')
+                {
+                    row |= Mask{1} << col;
+                    pattern.cols[col] |= rowBit;
+                }
+                else if(value != '.')
+                {
+                    return std::unexpected("invalid pattern cell");
+                }
+                ++col;
+            }
+        }
+        if(pattern.rows.empty())
+        {
+            return std::unexpected("empty pattern");
         }
-        return board;
+        return pattern;
     }
 }
 
@@ -109,75 +156,102 @@ namespace detail
         bool smudge = false;
     };
 
+    // The differences of a line pair are the popcount of their xor.
     template<typename Cmp>
     requires std::is_invocable_r_v<bool, Cmp &, uval> &&
              std::constructible_from<bool, Cmp>
-    std::optional<Reflection> findReflection(const Board &board)
+    std::optional<uval> findReflectionPos(std::span<const Mask> lines)
     {
-        using namespace std::placeholders;
-        using Symbol = std::vector<bool>;
-        const auto countDifferences = [](const auto &left, const auto &right) {
-            return std::ranges::fold_left(
-                std::views::zip_transform(std::not_equal_to<>{}, left, right),
-                static_cast<uval>(0), std::plus<>{});
-        };
-        const auto findPos = [&](const auto &board) -> std::optional<uval> {
-            std::vector<Symbol> symbols;
-            for(std::size_t row = 0; row < board.rows(); ++row)
+        for(std::size_t i = 1; i < lines.size(); ++i)
+        {
+            const auto size = std::min(i, lines.size() - i);
+            Cmp cmp;
+            bool matches = true;
+            for(std::size_t j = 0; j < size && matches; ++j)
             {
-                Symbol symb;
-                for(std::size_t col = 0; col < board.columns(); ++col)
-                {
-                    symb.push_back(static_cast<bool>(board.ix(row, col)));
-                }
-                symbols.push_back(std::move(symb));
+                matches = cmp(static_cast<uval>(
+                    std::popcount(lines[i - 1 - j] ^ lines[i + j])));
             }
-            const std::span<const Symbol> symbolsSpan{symbols};
-            for(std::size_t i = 1; i < symbols.size(); ++i)
+            if(matches && static_cast<bool>(cmp))
             {
-                const auto size = std::min(i, symbols.size() - i);
-                const auto left = symbolsSpan.subspan(i - size, size);
-                const auto right = symbolsSpan.subspan(i, size);
-                if([&] {
-                       Cmp cmp;
-                       for(const auto &[leftSymb, rightSymb] :
-                           std::views::zip(std::views::reverse(left), right))
-                       {
-                           const auto diff =
-                               countDifferences(leftSymb, rightSymb);
-                           if(!cmp(diff))
-                           {
-                               return false;
-                           }
-                       }
-                       return static_cast<bool>(cmp);
-                   }())
-                {
-                    return i;
-                }
+                return i;
             }
-            return std::nullopt;
-        };
-        if(const auto rowPos = findPos(board))
+        }
+        return std::nullopt;
+    }
+
+    template<typename Cmp>
+    std::optional<Reflection> findReflection(const Pattern &pattern)
+    {
+        if(const auto rowPos = findReflectionPos<Cmp>(pattern.rows))
         {
             return Reflection(*rowPos, Dir::HORIZONTAL);
         }
-        if(const auto colPos = findPos(board.transpose()))
+        if(const auto colPos = findReflectionPos<Cmp>(pattern.cols))
         {
             return Reflection(*colPos, Dir::VERTICAL);
         }
         return std::nullopt;
     }
+
+    // Parses and summarizes the patterns in parallel.
+    template<typename Cmp>
+    std::expected<uval, std::string> summarize(
+        std::span<const std::string_view> patterns)
+    {
+        using Partial = std::expected<uval, std::string>;
+        constexpr uval ROW_FACTOR = 100;
+        return xutil::parallelTryReduce(
+            patterns.size(), uval{0},
+            [&](const std::size_t begin, const std::size_t end) -> Partial {
+                uval result = 0;
+                for(auto idx = begin; idx < end; ++idx)
+                {
+                    const auto maybePattern =
+                        input::parsePattern(patterns[idx]);
+                    if(!maybePattern)
+                    {
+                        return std::unexpected(
+                            std::format("input pattern parsing failed: {}",
+                                        maybePattern.error()));
+                    }
+                    const auto maybeReflection =
+                        findReflection<Cmp>(*maybePattern);
+                    if(!maybeReflection)
+                    {
+                        return std::unexpected(std::format(
+                            "reflection not found: idx={}", idx));
+                    }
+                    result += maybeReflection->pos *
+                              (maybeReflection->direction == Dir::HORIZONTAL
+                                   ? ROW_FACTOR
+                                   : 1);
+                }
+                return result;
+            });
+    }
+}
+
+inline std::optional<Reflection> findReflection(const Pattern &pattern)
+{
+    return detail::findReflection<detail::Cmp>(pattern);
+}
+
+inline std::optional<Reflection> findSmudgedReflection(const Pattern &pattern)
+{
+    return detail::findReflection<detail::SmudgeCmp>(pattern);
 }
 
-inline std::optional<Reflection> findReflection(const Board &board)
+inline std::expected<uval, std::string> summarizeReflections(
+    std::span<const std::string_view> patterns)
 {
-    return detail::findReflection<detail::Cmp>(board);
+    return detail::summarize<detail::Cmp>(patterns);
 }
 
-inline std::optional<Reflection> findSmudgedReflection(const Board &board)
+inline std::expected<uval, std::string> summarizeSmudgedReflections(
+    std::span<const std::string_view> patterns)
 {
-    return detail::findReflection<detail::SmudgeCmp>(board);
+    return detail::summarize<detail::SmudgeCmp>(patterns);
 }
 }
 
@@ -6,12 +6,14 @@
 
 int main()
 {
-    auto maybeBoard = task::input::parseBoard(std::cin);
+    const auto maybeBoard = task::input::parseBoard(std::cin);
     if(!maybeBoard)
     {
         throw std::runtime_error(
             std::format("input parsing failed: {}", maybeBoard.error()));
     }
-    std::cout << task::totalLoad(task::tiltNorth(*maybeBoard)) << '\n';
+    task::Platform platform(*maybeBoard);
+    platform.tilt(task::Dir::NORTH);
+    std::cout << platform.load() << '\n';
     return 0;
 }
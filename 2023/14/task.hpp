@@ -2,19 +2,18 @@
 #define TASK_HPP
 
 #include <algorithm>
-#include <cmath>
+#include <array>
+#include <bit>
 #include <cstddef>
+#include <cstdint>
 #include <expected>
 #include <format>
-#include <functional>
 #include <istream>
-#include <ranges>
 #include <string>
 #include <utility>
 #include <vector>
 
-#include "../geom.hpp"
-#include "../geom_transform.hpp"
+#include "../cycle.hpp"
 #include "../matrix.hpp"
 
 namespace task
@@ -89,81 +88,326 @@ namespace input
     }
 }
 
-namespace detail
+enum class Dir
 {
-    using Pos = geom::Pos;
-}
+    NORTH,
+    WEST,
+    SOUTH,
+    EAST,
+};
 
-inline uval totalLoad(const Board &board)
+namespace detail
 {
-    const auto rows = board.columns();
-    uval load = 0;
-    for(std::size_t col = 0; col < board.columns(); ++col)
+    using Word = std::uint64_t;
+    constexpr std::size_t WORD_BITS = 64;
+    constexpr Word ALL_BITS = ~Word{};
+
+    // Bits of the positions [begin, end) within the word idx.
+    constexpr Word rangeBits(const std::size_t idx, const std::size_t begin,
+                             const std::size_t end)
     {
-        for(std::size_t row = 0; row < rows; ++row)
+        const auto first = idx * WORD_BITS;
+        if(end <= first || begin >= first + WORD_BITS)
         {
-            load += (board.ix(row, col) == Cell::ROUND) * (rows - row);
+            return 0;
         }
+        const auto low = std::max(begin, first) - first;
+        const auto high = std::min(end, first + WORD_BITS) - first;
+        if(low >= high)
+        {
+            return 0;
+        }
+        const auto upper = (high == WORD_BITS ? ALL_BITS
+                                              : (Word{1} << high) - 1);
+        return upper & (ALL_BITS << low);
     }
-    return load;
-}
 
-inline Board &tiltNorth(Board &board)
-{
-    const auto columns = board.columns();
-    for(std::size_t col = 0; col < columns; ++col)
+    // In place transpose of a 64x64 bit block, bit c of word r moves to
+    // bit r of word c.
+    inline void transposeBlock(std::array<Word, WORD_BITS> &block)
+    {
+        Word mask = 0x00000000FFFFFFFFULL;
+        for(std::size_t width = WORD_BITS / 2; width != 0;
+            width >>= 1, mask ^= mask << width)
+        {
+            for(std::size_t k = 0; k < WORD_BITS;
+                k = ((k | width) + 1) & ~width)
+            {
+                const auto diff = ((block[k] >> width) ^ block[k | width]) &
+                                  mask;
+                block[k] ^= diff << width;
+                block[k | width] ^= diff;
+            }
+        }
+    }
+
+    // `count` lines of `length` bits each.
+    class BitLines
     {
-        uval height = 0;
-        const auto handleColumn = [&](const std::size_t row) {
-            for(uval i = 0; i < height; ++i)
+    public:
+        BitLines(const std::size_t count, const std::size_t length)
+            : lineCount(count), lineLength(length),
+              words((length + WORD_BITS - 1) / WORD_BITS), data(count * words)
+        {
+        }
+
+        [[nodiscard]] std::size_t count() const
+        {
+            return lineCount;
+        }
+
+        [[nodiscard]] std::size_t length() const
+        {
+            return lineLength;
+        }
+
+        [[nodiscard]] bool test(const std::size_t line,
+                                const std::size_t pos) const
+        {
+            return (data[line * words + pos / WORD_BITS] >>
+                    (pos % WORD_BITS)) &
+                   1;
+        }
+
+        void set(const std::size_t line, const std::size_t pos)
+        {
+            data[line * words + pos / WORD_BITS] |= Word{1}
+                                                    << (pos % WORD_BITS);
+        }
+
+        [[nodiscard]] std::size_t popcount(const std::size_t line,
+                                           const std::size_t begin,
+                                           const std::size_t end) const
+        {
+            std::size_t result = 0;
+            for(auto idx = begin / WORD_BITS; idx * WORD_BITS < end; ++idx)
+            {
+                result += std::popcount(data[line * words + idx] &
+                                        rangeBits(idx, begin, end));
+            }
+            return result;
+        }
+
+        // Moves the `count` set bits of [begin, end) to one of its ends,
+        // calling `onToggle(pos)` for every bit that changes.
+        template<typename Func>
+        void compact(const std::size_t line, const std::size_t begin,
+                     const std::size_t end, const std::size_t count,
+                     const bool toBegin, Func &&onToggle)
+        {
+            const auto fillBegin = (toBegin ? begin : end - count);
+            const auto fillEnd = (toBegin ? begin + count : end);
+            for(auto idx = begin / WORD_BITS; idx * WORD_BITS < end; ++idx)
             {
-                board.ix(row + i, col) = Cell::ROUND;
+                auto &word = data[line * words + idx];
+                const auto next = (word & ~rangeBits(idx, begin, end)) |
+                                  rangeBits(idx, fillBegin, fillEnd);
+                for(auto changed = word ^ next; changed != 0;
+                    changed &= changed - 1)
+                {
+                    onToggle(idx * WORD_BITS +
+                             static_cast<std::size_t>(
+                                 std::countr_zero(changed)));
+                }
+                word = next;
             }
-        };
-        for(auto row = board.rows(); row > 0; --row)
+        }
+
+        void transposeInto(BitLines &result) const
         {
-            auto &val = board.ix(row - 1, col);
-            if(val == Cell::ROUND)
+            std::array<Word, WORD_BITS> block{};
+            for(std::size_t lineBlock = 0; lineBlock < lineCount;
+                lineBlock += WORD_BITS)
             {
-                ++height;
-                val = Cell::EMPTY;
+                for(std::size_t idx = 0; idx < words; ++idx)
+                {
+                    for(std::size_t i = 0; i < WORD_BITS; ++i)
+                    {
+                        block[i] = (lineBlock + i < lineCount
+                                        ? data[(lineBlock + i) * words + idx]
+                                        : 0);
+                    }
+                    transposeBlock(block);
+                    for(std::size_t i = 0; i < WORD_BITS &&
+                                           idx * WORD_BITS + i < lineLength;
+                        ++i)
+                    {
+                        result.data[(idx * WORD_BITS + i) * result.words +
+                                    lineBlock / WORD_BITS] = block[i];
+                    }
+                }
             }
-            else if(val == Cell::CUBE)
+        }
+
+    private:
+        std::size_t lineCount{};
+        std::size_t lineLength{};
+        std::size_t words{};
+        std::vector<Word> data;
+    };
+
+    // Run of cells between two cubes or the border along a line.
+    struct Segment
+    {
+        std::uint32_t line{};
+        std::uint32_t begin{};
+        std::uint32_t end{};
+    };
+
+    inline std::vector<Segment> prepareSegments(const BitLines &cubes)
+    {
+        std::vector<Segment> result;
+        for(std::size_t line = 0; line < cubes.count(); ++line)
+        {
+            std::size_t begin = 0;
+            for(std::size_t pos = 0; pos <= cubes.length(); ++pos)
             {
-                handleColumn(row);
-                height = 0;
+                if(pos == cubes.length() || cubes.test(line, pos))
+                {
+                    if(pos - begin > 1)
+                    {
+                        result.push_back({static_cast<std::uint32_t>(line),
+                                          static_cast<std::uint32_t>(begin),
+                                          static_cast<std::uint32_t>(pos)});
+                    }
+                    begin = pos + 1;
+                }
             }
         }
-        handleColumn(0);
+        return result;
     }
-    return board;
 }
 
-inline Board cyclePlatform(const Board &board, const ulval cycles)
+// Round rocks kept as bit rows and bit columns, only one of them is up to
+// date at a time. A tilt compacts the rocks of every segment between cubes
+// to one of its ends, the other orientation is refreshed by a blockwise bit
+// transpose when a tilt needs it. The Zobrist hash of the rock cells is
+// updated with every rock a tilt moves instead of rehashing the board.
+class Platform
 {
-    constexpr detail::Pos ROT_LEFT{0, 1};
-    constexpr detail::Pos ROT_RIGHT{0, -1};
-    std::vector<Board> prevs{board};
-    for(ulval i = 0; i < cycles; ++i)
+public:
+    explicit Platform(const Board &board)
+        : rowRounds(board.rows(), board.columns()),
+          colRounds(board.columns(), board.rows()),
+          keys(board.rows() * board.columns())
+    {
+        detail::BitLines rowCubes(board.rows(), board.columns());
+        detail::BitLines colCubes(board.columns(), board.rows());
+        for(std::size_t row = 0; row < board.rows(); ++row)
+        {
+            for(std::size_t col = 0; col < board.columns(); ++col)
+            {
+                if(board.ix(row, col) == Cell::ROUND)
+                {
+                    rowRounds.set(row, col);
+                    colRounds.set(col, row);
+                    hash = keys.toggle(hash, row * board.columns() + col);
+                }
+                else if(board.ix(row, col) == Cell::CUBE)
+                {
+                    rowCubes.set(row, col);
+                    colCubes.set(col, row);
+                }
+            }
+        }
+        rowSegments = detail::prepareSegments(rowCubes);
+        colSegments = detail::prepareSegments(colCubes);
+    }
+
+    void tilt(const Dir dir)
+    {
+        const bool alongColumns = (dir == Dir::NORTH || dir == Dir::SOUTH);
+        const bool toBegin = (dir == Dir::NORTH || dir == Dir::WEST);
+        if(alongColumns != columnsCurrent)
+        {
+            (alongColumns ? rowRounds : colRounds)
+                .transposeInto(alongColumns ? colRounds : rowRounds);
+            columnsCurrent = alongColumns;
+        }
+        auto &rounds = (alongColumns ? colRounds : rowRounds);
+        const auto columns = rowRounds.length();
+        for(const auto &segment :
+            (alongColumns ? colSegments : rowSegments))
+        {
+            const auto count =
+                rounds.popcount(segment.line, segment.begin, segment.end);
+            rounds.compact(segment.line, segment.begin, segment.end, count,
+                           toBegin, [&](const std::size_t pos) {
+                               hash = keys.toggle(
+                                   hash, (alongColumns
+                                              ? pos * columns + segment.line
+                                              : segment.line * columns + pos));
+                           });
+        }
+    }
+
+    void spin()
     {
-        auto cur = prevs.back();
-        for(const auto &rotation :
-            {ROT_RIGHT, rotate(rotate(ROT_LEFT, ROT_LEFT), ROT_LEFT), ROT_RIGHT,
-             ROT_RIGHT})
+        for(const auto dir : {Dir::NORTH, Dir::WEST, Dir::SOUTH, Dir::EAST})
         {
-            tiltNorth(cur);
-            cur = geom::rotate(cur, rotation);
+            tilt(dir);
         }
-        const auto iter = std::ranges::find(prevs, cur);
-        if(iter != std::ranges::end(prevs))
+    }
+
+    // Load on the north support beams.
+    [[nodiscard]] ulval load() const
+    {
+        ulval result = 0;
+        if(columnsCurrent)
+        {
+            const auto rows = colRounds.length();
+            for(std::size_t col = 0; col < colRounds.count(); ++col)
+            {
+                for(std::size_t row = 0; row < rows; ++row)
+                {
+                    result += colRounds.test(col, row) * (rows - row);
+                }
+            }
+            return result;
+        }
+        const auto rows = rowRounds.count();
+        for(std::size_t row = 0; row < rows; ++row)
+        {
+            result += static_cast<ulval>(rowRounds.popcount(
+                          row, 0, rowRounds.length())) *
+                      (rows - row);
+        }
+        return result;
+    }
+
+    [[nodiscard]] xutil::Fingerprint fingerprint() const
+    {
+        return hash;
+    }
+
+private:
+    detail::BitLines rowRounds;
+    detail::BitLines colRounds;
+    std::vector<detail::Segment> rowSegments;
+    std::vector<detail::Segment> colSegments;
+    xutil::ZobristTable keys;
+    xutil::Fingerprint hash{};
+    bool columnsCurrent{false};
+};
+
+inline Platform cyclePlatform(Platform platform, const ulval cycles)
+{
+    xutil::CycleDetector detector;
+    detector.observe(platform.fingerprint());
+    for(ulval i = 0; i < cycles; ++i)
+    {
+        platform.spin();
+        if(const auto maybeCycle = detector.observe(platform.fingerprint()))
         {
-            const auto loopInit = iter - std::ranges::begin(prevs);
-            const auto loopSize = prevs.size() - loopInit;
-            return prevs[loopInit + ((cycles - loopInit) % loopSize)];
+            const auto remaining = (cycles - i - 1) % maybeCycle->length;
+            for(ulval j = 0; j < remaining; ++j)
+            {
+                platform.spin();
+            }
+            break;
         }
-        prevs.push_back(std::move(cur));
     }
-    return {};
+    return platform;
 }
 }
 
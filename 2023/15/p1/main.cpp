@@ -1,18 +1,12 @@
-#include <algorithm>
-#include <functional>
 #include <iostream>
-#include <ranges>
 
+#include "../../mapped_input.hpp"
 #include "../task.hpp"
 
 int main()
 {
-    const auto sum =
-        std::ranges::fold_left(task::input::readInput(std::cin) |
-                                   std::views::transform([](const auto &str) {
-                                       return task::hash(str);
-                                   }),
-                               static_cast<task::uval>(0), std::plus<>{});
-    std::cout << sum << '\n';
+    const xutil::MappedInput input;
+    const auto steps = task::input::splitSteps(input.view());
+    std::cout << task::sumHashes(steps) << '\n';
     return 0;
 }
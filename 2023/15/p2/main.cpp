@@ -2,16 +2,18 @@
 #include <iostream>
 #include <stdexcept>
 
+#include "../../mapped_input.hpp"
 #include "../task.hpp"
 
 int main()
 {
-    const auto maybeSteps = task::input::readSteps(std::cin);
-    if(!maybeSteps)
+    const xutil::MappedInput input;
+    const auto maybeSequence = task::input::readSteps(input.view());
+    if(!maybeSequence)
     {
         throw std::runtime_error(
-            std::format("input parsing failed: {}", maybeSteps.error()));
+            std::format("input parsing failed: {}", maybeSequence.error()));
     }
-    std::cout << task::executeSteps(*maybeSteps) << '\n';
+    std::cout << task::executeSteps(*maybeSequence) << '\n';
     return 0;
 }
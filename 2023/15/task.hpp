@@ -4,25 +4,24 @@
 #include <algorithm>
 #include <array>
 #include <cctype>
+#include <charconv>
 #include <concepts>
 #include <cstddef>
 #include <cstdint>
 #include <expected>
 #include <format>
-#include <functional>
-#include <istream>
-#include <iterator>
 #include <limits>
-#include <list>
 #include <ranges>
+#include <span>
 #include <string>
 #include <string_view>
+#include <system_error>
 #include <unordered_map>
 #include <utility>
 #include <variant>
 #include <vector>
 
-#include "../base.hpp"
+#include "../parallel.hpp"
 
 namespace task
 {
@@ -30,6 +29,7 @@ using uval = unsigned int;
 using ulval = unsigned long long int;
 
 using Hash = std::uint8_t;
+using LabelId = std::uint32_t;
 
 struct OperationSet
 {
@@ -43,46 +43,71 @@ using Operation = std::variant<OperationSet, OperationRemove>;
 struct Step
 {
     Operation operation{};
-    std::string label{};
+    LabelId label{};
+};
+
+// Steps referring to their labels by id, `labels` views the input text and
+// holds each distinct label once.
+struct Sequence
+{
+    std::vector<Step> steps;
+    std::vector<std::string_view> labels;
 };
 
 namespace input
 {
-    inline auto readInput(std::istream &stream)
+    // The comma separated steps of `text`, line breaks around them dropped.
+    inline std::vector<std::string_view> splitSteps(std::string_view text)
     {
-        return std::ranges::subrange(std::istreambuf_iterator<char>{stream},
-                                     std::istreambuf_iterator<char>{}) |
-               std::views::filter([](const auto val) { return val != '\n'; }) |
-               std::views::lazy_split(',');
+        constexpr std::string_view BLANKS = "\r\n";
+        std::vector<std::string_view> result;
+        while(!text.empty())
+        {
+            const auto end = std::min(text.find(','), text.size());
+            auto step = text.substr(0, end);
+            step.remove_prefix(std::min(step.find_first_not_of(BLANKS),
+                                        step.size()));
+            step.remove_suffix(step.size() -
+                               (step.find_last_not_of(BLANKS) + 1));
+            if(!step.empty())
+            {
+                result.push_back(step);
+            }
+            text.remove_prefix(std::min(end + 1, text.size()));
+        }
+        return result;
     }
 
-    inline std::expected<std::vector<Step>, std::string> readSteps(
-        std::istream &stream)
+    inline std::expected<Sequence, std::string> readSteps(
+        const std::string_view text)
     {
-        std::vector<Step> result;
-        for(const auto &stepView :
-            std::ranges::subrange(std::istreambuf_iterator<char>{stream},
-                                  std::istreambuf_iterator<char>{}) |
-                std::views::filter([](const auto val) { return val != '\n'; }) |
-                std::views::lazy_split(','))
+        Sequence result;
+        std::unordered_map<std::string_view, LabelId> labelIds;
+        for(const auto str : splitSteps(text))
         {
-            std::string str;
-            std::ranges::copy(stepView, std::back_inserter(str));
-            const auto opIter = std::ranges::find_if_not(
-                str, [](const auto val) { return std::isalnum(val); });
-            if(opIter == std::ranges::end(str))
+            const auto opPos =
+                std::ranges::find_if_not(
+                    str, [](const auto val) { return std::isalnum(val); }) -
+                str.begin();
+            if(static_cast<std::size_t>(opPos) == str.size())
             {
                 return std::unexpected("invalid step: missing operation");
             }
-            const auto operation = *opIter;
+            const auto operation = str[opPos];
+            const auto label = str.substr(0, opPos);
+            const auto [iter, inserted] = labelIds.try_emplace(
+                label, static_cast<LabelId>(result.labels.size()));
+            if(inserted)
+            {
+                result.labels.push_back(label);
+            }
             Step step{
                 .operation = {},
-                .label = {std::ranges::begin(str), opIter},
+                .label = iter->second,
             };
             if(operation == '-')
             {
-                const auto endIter = opIter + 1;
-                if(endIter != std::ranges::end(str))
+                if(static_cast<std::size_t>(opPos) + 1 != str.size())
                 {
                     return std::unexpected("invalid step: extra characters");
                 }
@@ -90,21 +115,23 @@ namespace input
             }
             else if(operation == '=')
             {
-                const auto nextIter = opIter + 1;
-                const auto maybeFocalLength = base::parseValue<uval>(
-                    std::string_view(nextIter, std::ranges::end(str)));
-                if(!maybeFocalLength)
+                const auto value = str.substr(opPos + 1);
+                uval focalLength{};
+                const auto [ptr, ec] = std::from_chars(
+                    value.data(), value.data() + value.size(), focalLength);
+                if(value.empty() || ec != std::errc{} ||
+                   ptr != value.data() + value.size())
                 {
                     return std::unexpected("invalid focal length");
                 }
-                step.operation = OperationSet{*maybeFocalLength};
+                step.operation = OperationSet{focalLength};
             }
             else
             {
                 return std::unexpected(std::format(
                     "invalid step: unknown operation: {}", operation));
             }
-            result.push_back(std::move(step));
+            result.steps.push_back(step);
         }
         return result;
     }
@@ -128,85 +155,173 @@ constexpr Hash hash(const R &str)
 
 namespace detail
 {
+    // 17^k = (1 + 16)^k = 1 + 16k (mod 256), so the hash of c[0..n) is
+    // S + 16 (n S - W) with S the sum of the characters and W the sum of
+    // c[k] k: two plain sums instead of a chain of multiplications, and
+    // zero padding changes neither.
+    constexpr Hash finishHash(const uval sum, const uval weighted,
+                              const uval length)
+    {
+        return static_cast<Hash>(sum + 16 * (length * sum - weighted));
+    }
+
+    constexpr std::size_t HASH_LANES = 16;
+}
+
+// Sum of the hashes of all `steps`, hashed HASH_LANES at a time in lockstep
+// so that the lanes vectorise instead of waiting on each other.
+inline ulval sumHashes(const std::span<const std::string_view> steps)
+{
+    constexpr auto LANES = detail::HASH_LANES;
+    return xutil::parallelReduce(
+        steps.size(), ulval{},
+        [&](const std::size_t begin, const std::size_t end) {
+            ulval total = 0;
+            for(auto first = begin; first < end; first += LANES)
+            {
+                const auto count = std::min(LANES, end - first);
+                std::array<const char *, LANES> data{};
+                std::array<uval, LANES> lengths{};
+                std::array<uval, LANES> sums{};
+                std::array<uval, LANES> weighted{};
+                uval longest = 0;
+                for(std::size_t lane = 0; lane < count; ++lane)
+                {
+                    data[lane] = steps[first + lane].data();
+                    lengths[lane] =
+                        static_cast<uval>(steps[first + lane].size());
+                    longest = std::max(longest, lengths[lane]);
+                }
+                for(uval pos = 0; pos < longest; ++pos)
+                {
+                    for(std::size_t lane = 0; lane < LANES; ++lane)
+                    {
+                        const uval val =
+                            (pos < lengths[lane]
+                                 ? static_cast<unsigned char>(data[lane][pos])
+                                 : 0);
+                        sums[lane] += val;
+                        weighted[lane] += pos * val;
+                    }
+                }
+                for(std::size_t lane = 0; lane < count; ++lane)
+                {
+                    total += detail::finishHash(sums[lane], weighted[lane],
+                                                lengths[lane]);
+                }
+            }
+            return total;
+        });
+}
+
+namespace detail
+{
+    constexpr std::uint32_t NO_POSITION =
+        std::numeric_limits<std::uint32_t>::max();
+    constexpr LabelId NO_LABEL = std::numeric_limits<LabelId>::max();
+
+    // Lenses in insertion order, removed ones are left as tombstones until
+    // they outnumber the live ones. `positions` maps a label id to its slot
+    // in the box holding it.
     class Box
     {
     public:
-        void set(const std::string &label, uval value)
+        void set(const LabelId label, const uval value,
+                 std::vector<std::uint32_t> &positions)
         {
-            if(auto iter = labelLens.find(label); iter != end(labelLens))
-            {
-                *(iter->second) = value;
-            }
-            else
+            auto &pos = positions[label];
+            if(pos != NO_POSITION)
             {
-                labelLens.insert_or_assign(label,
-                                           lens.insert(end(lens), value));
+                slots[pos].value = value;
+                return;
             }
+            pos = static_cast<std::uint32_t>(slots.size());
+            slots.push_back({label, value});
         }
-        void remove(const std::string &label)
+        void remove(const LabelId label, std::vector<std::uint32_t> &positions)
         {
-            if(auto iter = labelLens.find(label); iter != end(labelLens))
+            auto &pos = positions[label];
+            if(pos == NO_POSITION)
             {
-                lens.erase(iter->second);
-                labelLens.erase(iter);
+                return;
+            }
+            slots[pos].label = NO_LABEL;
+            pos = NO_POSITION;
+            if(++tombstones * 2 > slots.size())
+            {
+                compact(positions);
             }
         }
 
         ulval focusingPower() const
         {
-            return std::ranges::fold_left(
-                std::views::enumerate(lens) |
-                    std::views::transform([](const auto &p) {
-                        const auto &[idx, val] = p;
-                        return (idx + 1) * static_cast<ulval>(val);
-                    }),
-                static_cast<ulval>(0), std::plus<>{});
+            ulval result = 0;
+            ulval rank = 0;
+            for(const auto &slot : slots)
+            {
+                if(slot.label != NO_LABEL)
+                {
+                    result += ++rank * slot.value;
+                }
+            }
+            return result;
         }
 
     private:
-        using LensList = std::list<uval>;
+        struct Slot
+        {
+            LabelId label{};
+            uval value{};
+        };
+
+        void compact(std::vector<std::uint32_t> &positions)
+        {
+            std::erase_if(slots, [](const Slot &slot) {
+                return slot.label == NO_LABEL;
+            });
+            for(std::size_t idx = 0; idx < slots.size(); ++idx)
+            {
+                positions[slots[idx].label] = static_cast<std::uint32_t>(idx);
+            }
+            tombstones = 0;
+        }
 
-        LensList lens;
-        std::unordered_map<std::string, LensList::iterator> labelLens;
+        std::vector<Slot> slots;
+        std::size_t tombstones{};
     };
 }
 
-template<std::ranges::forward_range R>
-requires std::same_as<std::ranges::range_value_t<R>, Step>
-ulval executeSteps(const R &steps)
+inline ulval executeSteps(const Sequence &sequence)
 {
-    struct Visitor
+    constexpr auto BOXES =
+        static_cast<std::size_t>(std::numeric_limits<Hash>::max()) + 1;
+    std::vector<Hash> labelBoxes;
+    labelBoxes.reserve(sequence.labels.size());
+    for(const auto label : sequence.labels)
     {
-        void operator()(const OperationRemove &) const
+        labelBoxes.push_back(hash(label));
+    }
+    std::vector<std::uint32_t> positions(sequence.labels.size(),
+                                         detail::NO_POSITION);
+    std::array<detail::Box, BOXES> boxes{};
+    for(const auto &step : sequence.steps)
+    {
+        auto &box = boxes[labelBoxes[step.label]];
+        if(const auto *set = std::get_if<OperationSet>(&step.operation))
         {
-            box.remove(label);
+            box.set(step.label, set->value, positions);
         }
-        void operator()(const OperationSet &op) const
+        else
         {
-            box.set(label, op.value);
+            box.remove(step.label, positions);
         }
-
-        const std::string &label;
-        detail::Box &box;
-    };
-    std::array<detail::Box,
-               static_cast<std::size_t>(std::numeric_limits<Hash>::max()) + 1>
-        boxes{};
-    for(const auto &step : steps)
+    }
+    ulval result = 0;
+    for(std::size_t idx = 0; idx < BOXES; ++idx)
     {
-        auto &box = boxes[hash(step.label)];
-        std::visit(Visitor{step.label, box}, step.operation);
+        result += (idx + 1) * boxes[idx].focusingPower();
     }
-    return std::ranges::fold_left(
-        std::views::enumerate(boxes |
-                              std::views::transform([](const auto &box) {
-                                  return box.focusingPower();
-                              })) |
-            std::views::transform([](const auto &p) {
-                const auto &[idx, val] = p;
-                return (idx + 1) * static_cast<ulval>(val);
-            }),
-        static_cast<ulval>(0), std::plus<>{});
+    return result;
 }
 }
 
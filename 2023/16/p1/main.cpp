@@ -1,4 +1,3 @@
-#include <cstddef>
 #include <format>
 #include <iostream>
 #include <stdexcept>
@@ -13,7 +12,6 @@ int main()
         throw std::runtime_error(
             std::format("can't parse input: {}", maybeBoard.error()));
     }
-    const auto result = task::runBeam(*maybeBoard, {0, 0}, {0, 1});
-    std::cout << task::totalEnergy(result) << '\n';
+    std::cout << task::runBeam(*maybeBoard, {0, 0}, task::Dir::RIGHT) << '\n';
     return 0;
 }
@@ -1,47 +1,70 @@
 #ifndef TASK_HPP
 #define TASK_HPP
 
+#include <algorithm>
+#include <array>
+#include <bit>
 #include <cstddef>
+#include <cstdint>
 #include <expected>
 #include <format>
 #include <istream>
-#include <queue>
-#include <set>
+#include <limits>
 #include <string>
 #include <utility>
-#include <variant>
 #include <vector>
 
 #include "../geom.hpp"
-#include "../geom_transform.hpp"
-#include "../matrix.hpp"
+#include "../graph_scc.hpp"
+#include "../parallel.hpp"
 
 namespace task
 {
-namespace detail
+enum class Cell : std::uint8_t
 {
-    struct CellEmpty
-    {
-    };
-    struct CellSplitter
-    {
-        bool vertical{};
-    };
-    struct CellMirror
-    {
-        geom::TransformMatrix transform{};
-    };
-}
-using Cell =
-    std::variant<detail::CellEmpty, detail::CellSplitter, detail::CellMirror>;
+    OUTSIDE = 0,
+    EMPTY,
+    MIRROR_BACKSLASH,
+    MIRROR_SLASH,
+    SPLITTER_HORIZONTAL,
+    SPLITTER_VERTICAL,
+};
+
+enum class Dir : std::uint8_t
+{
+    UP = 0,
+    RIGHT,
+    DOWN,
+    LEFT,
+};
 
 using uval = unsigned int;
-using Board = numutil::Matrix<Cell>;
-using EnergizedBoard = numutil::Matrix<int>;
+using Size = std::size_t;
 using Pos = geom::Pos;
+using DirMask = std::uint8_t;
 
-constexpr Pos ROT_LEFT{0, 1};
-constexpr Pos ROT_RIGHT{0, -1};
+constexpr std::size_t CELL_KINDS =
+    std::to_underlying(Cell::SPLITTER_VERTICAL) + 1;
+constexpr std::size_t DIRS = 4;
+
+// Row major cells surrounded by a border of OUTSIDE ones, which stop every
+// beam leaving the contraption.
+struct Board
+{
+    std::vector<Cell> cells;
+    Size rows{};
+    Size columns{};
+
+    [[nodiscard]] Size width() const
+    {
+        return columns + 2;
+    }
+    [[nodiscard]] Size index(const Pos &pos) const
+    {
+        return (static_cast<Size>(pos.r) + 1) * width() +
+               static_cast<Size>(pos.c) + 1;
+    }
+};
 
 namespace input
 {
@@ -52,17 +75,15 @@ namespace input
             switch(val)
             {
             case '.':
-                return Cell{task::detail::CellEmpty{}};
+                return Cell::EMPTY;
             case '\\':
-                return Cell{task::detail::CellMirror{
-                    geom::prepareTransform({{{0, 1}, {1, 0}}})}};
+                return Cell::MIRROR_BACKSLASH;
             case '/':
-                return Cell{task::detail::CellMirror{
-                    geom::prepareTransform({{{0, -1}, {-1, 0}}})}};
+                return Cell::MIRROR_SLASH;
             case '-':
-                return Cell{task::detail::CellSplitter{false}};
+                return Cell::SPLITTER_HORIZONTAL;
             case '|':
-                return Cell{task::detail::CellSplitter{true}};
+                return Cell::SPLITTER_VERTICAL;
             default:
                 return std::unexpected(
                     std::format("invalid cell value: {}", val));
@@ -87,7 +108,12 @@ namespace input
             }
             rows.push_back(std::move(line));
         }
-        Board board(rows.size(), rows.front().size());
+        if(rows.empty())
+        {
+            return std::unexpected("empty board");
+        }
+        Board board{{}, rows.size(), rows.front().size()};
+        board.cells.assign(board.width() * (board.rows + 2), Cell::OUTSIDE);
         for(std::size_t rowIdx = 0; rowIdx < rows.size(); ++rowIdx)
         {
             const auto &row = rows[rowIdx];
@@ -100,89 +126,280 @@ namespace input
                     return std::unexpected(std::format(
                         "board parsing failed: {}", maybeCell.error()));
                 }
-                board.ix(rowIdx, colIdx) = *maybeCell;
+                board.cells[board.index(Pos{static_cast<int>(rowIdx),
+                                            static_cast<int>(colIdx)})] =
+                    *maybeCell;
             }
         }
         return board;
     }
 }
 
-inline EnergizedBoard runBeam(const Board &board, const Pos &pos,
-                              const Pos &dir)
+namespace detail
 {
-    struct Cand
+    using Transitions = std::array<std::array<DirMask, DIRS>, CELL_KINDS>;
+
+    constexpr DirMask dirBit(const Dir dir)
     {
-        Pos pos{};
-        Pos dir{};
+        return static_cast<DirMask>(1U << std::to_underlying(dir));
+    }
+
+    // The directions leaving a cell entered moving in a direction, a single
+    // one except for a splitter entered across.
+    constexpr Transitions TRANSITIONS = [] {
+        constexpr auto UP = dirBit(Dir::UP);
+        constexpr auto RIGHT = dirBit(Dir::RIGHT);
+        constexpr auto DOWN = dirBit(Dir::DOWN);
+        constexpr auto LEFT = dirBit(Dir::LEFT);
+        Transitions result{};
+        result[std::to_underlying(Cell::EMPTY)] = {UP, RIGHT, DOWN, LEFT};
+        result[std::to_underlying(Cell::MIRROR_BACKSLASH)] = {LEFT, DOWN, RIGHT,
+                                                              UP};
+        result[std::to_underlying(Cell::MIRROR_SLASH)] = {RIGHT, UP, LEFT,
+                                                          DOWN};
+        result[std::to_underlying(Cell::SPLITTER_HORIZONTAL)] = {
+            LEFT | RIGHT, RIGHT, LEFT | RIGHT, LEFT};
+        result[std::to_underlying(Cell::SPLITTER_VERTICAL)] = {
+            UP, UP | DOWN, DOWN, UP | DOWN};
+        return result;
+    }();
+
+    constexpr bool splits(const Cell cell, const Dir dir)
+    {
+        return std::popcount(
+                   TRANSITIONS[std::to_underlying(cell)][std::to_underlying(
+                       dir)]) > 1;
+    }
+
+    inline std::array<std::ptrdiff_t, DIRS> indexSteps(const Board &board)
+    {
+        const auto width = static_cast<std::ptrdiff_t>(board.width());
+        return {-width, 1, width, -1};
+    }
+
+    class TileSet
+    {
+    public:
+        explicit TileSet(const Size size)
+            : words((size + WORD_BITS - 1) / WORD_BITS)
+        {
+        }
+
+        void set(const Size idx)
+        {
+            words[idx / WORD_BITS] |= std::uint64_t{1} << (idx % WORD_BITS);
+        }
+        TileSet &operator|=(const TileSet &other)
+        {
+            for(std::size_t idx = 0; idx < words.size(); ++idx)
+            {
+                words[idx] |= other.words[idx];
+            }
+            return *this;
+        }
+        [[nodiscard]] uval count() const
+        {
+            uval result = 0;
+            for(const auto word : words)
+            {
+                result += static_cast<uval>(std::popcount(word));
+            }
+            return result;
+        }
+
+    private:
+        static constexpr Size WORD_BITS = 64;
+
+        std::vector<std::uint64_t> words;
     };
-    using CandQueue = std::queue<Cand>;
-    struct CellVisitor
+}
+
+// Number of the tiles energized by a beam entering `pos` moving in `dir`,
+// simulated with a mask of the directions seen in every cell.
+inline uval runBeam(const Board &board, const Pos &pos, const Dir dir)
+{
+    const auto steps = detail::indexSteps(board);
+    std::vector<DirMask> seen(board.cells.size());
+    std::vector<std::pair<Size, Dir>> beams{{board.index(pos), dir}};
+    uval energized = 0;
+    while(!beams.empty())
     {
-        void operator()(const detail::CellEmpty &) const
+        auto [idx, cur] = beams.back();
+        beams.pop_back();
+        while(board.cells[idx] != Cell::OUTSIDE &&
+              !(seen[idx] & detail::dirBit(cur)))
         {
+            energized += (seen[idx] == 0);
+            seen[idx] |= detail::dirBit(cur);
+            auto next = detail::TRANSITIONS[std::to_underlying(
+                board.cells[idx])][std::to_underlying(cur)];
+            cur = static_cast<Dir>(std::countr_zero(next));
+            next &= next - 1;
+            if(next != 0)
+            {
+                const auto other = static_cast<Dir>(std::countr_zero(next));
+                beams.emplace_back(idx + steps[std::to_underlying(other)],
+                                   other);
+            }
+            idx += steps[std::to_underlying(cur)];
         }
-        void operator()(const detail::CellSplitter &cell) const
+    }
+    return energized;
+}
+
+// Beam paths condensed between splitters: a splitter entered across starts
+// the same two paths whatever the beam reaching it, so the tiles energized
+// from it are computed once per strongly connected component of the
+// splitter graph and shared by all the entries reaching it.
+class BeamGraph
+{
+public:
+    explicit BeamGraph(const Board &board)
+        : board(&board), steps(detail::indexSteps(board)),
+          nodes(board.cells.size(), NO_NODE)
+    {
+        std::vector<Size> splitters;
+        for(Size idx = 0; idx < board.cells.size(); ++idx)
+        {
+            if(board.cells[idx] == Cell::SPLITTER_HORIZONTAL ||
+               board.cells[idx] == Cell::SPLITTER_VERTICAL)
+            {
+                nodes[idx] = static_cast<graphutil::NodeIdx>(splitters.size());
+                splitters.push_back(idx);
+            }
+        }
+        graphutil::Adjacency successors(splitters.size());
+        std::vector<detail::TileSet> own;
+        own.reserve(splitters.size());
+        for(std::size_t node = 0; node < splitters.size(); ++node)
         {
-            const Pos dir{!cell.vertical, cell.vertical};
-            if(cand.dir.r * dir.r != 0 || cand.dir.c * dir.c != 0)
+            const auto idx = splitters[node];
+            auto &tiles = own.emplace_back(board.cells.size());
+            tiles.set(idx);
+            const auto across = (board.cells[idx] == Cell::SPLITTER_VERTICAL
+                                     ? Dir::RIGHT
+                                     : Dir::UP);
+            auto outs = detail::TRANSITIONS[std::to_underlying(
+                board.cells[idx])][std::to_underlying(across)];
+            for(; outs != 0; outs &= outs - 1)
             {
+                const auto out = static_cast<Dir>(std::countr_zero(outs));
+                const auto next = trace(idx + steps[std::to_underlying(out)],
+                                        out, tiles);
+                if(next != NO_NODE)
                 {
-                    auto other = cand;
-                    other.dir = rotate(other.dir, ROT_LEFT);
-                    cands.push(other);
+                    successors[node].push_back(next);
                 }
-                cand.dir = rotate(cand.dir, ROT_RIGHT);
             }
         }
-        void operator()(const detail::CellMirror &cell) const
+        const auto components =
+            graphutil::stronglyConnectedComponents(successors);
+        componentOf = components.component;
+        std::vector<std::vector<graphutil::NodeIdx>> members(
+            components.count);
+        for(graphutil::NodeIdx node = 0; node < splitters.size(); ++node)
         {
-            cand.dir = geom::transform(cand.dir, cell.transform);
+            members[componentOf[node]].push_back(node);
+        }
+        reached.reserve(components.count);
+        for(graphutil::NodeIdx component = 0; component < components.count;
+            ++component)
+        {
+            auto &tiles = reached.emplace_back(board.cells.size());
+            for(const auto node : members[component])
+            {
+                tiles |= own[node];
+                for(const auto succ : successors[node])
+                {
+                    if(componentOf[succ] != component)
+                    {
+                        tiles |= reached[componentOf[succ]];
+                    }
+                }
+            }
         }
+    }
 
-        Cand &cand;
-        CandQueue &cands;
-    };
-    numutil::Matrix<std::set<Pos>> seen(board.rows(), board.columns());
-    CandQueue cands;
-    cands.push({pos, dir});
-    while(!cands.empty())
+    [[nodiscard]] uval energized(const Pos &pos, const Dir dir) const
     {
-        auto &cur = cands.front();
-        auto &[curPos, curDir] = cur;
-        if(curPos.r < 0 || static_cast<std::size_t>(curPos.r) >= board.rows() ||
-           curPos.c < 0 ||
-           static_cast<std::size_t>(curPos.c) >= board.columns() ||
-           !seen.ix(curPos.r, curPos.c).insert(curDir).second)
-        {
-            cands.pop();
-            continue;
-        }
-        std::visit(CellVisitor{cur, cands}, board.ix(curPos.r, curPos.c));
-        curPos = curPos + curDir;
+        detail::TileSet tiles(board->cells.size());
+        if(const auto node = trace(board->index(pos), dir, tiles);
+           node != NO_NODE)
+        {
+            tiles |= reached[componentOf[node]];
+        }
+        return tiles.count();
     }
-    EnergizedBoard result(seen.rows(), seen.columns());
-    for(std::size_t row = 0; row < result.rows(); ++row)
+
+    // The most tiles energized by a beam entering from any edge tile.
+    [[nodiscard]] uval maxEnergy() const
     {
-        for(std::size_t col = 0; col < result.columns(); ++col)
+        const auto rows = static_cast<int>(board->rows);
+        const auto columns = static_cast<int>(board->columns);
+        std::vector<std::pair<Pos, Dir>> entries;
+        for(int row = 0; row < rows; ++row)
         {
-            result.ix(row, col) = !seen.ix(row, col).empty();
+            entries.emplace_back(Pos{row, 0}, Dir::RIGHT);
+            entries.emplace_back(Pos{row, columns - 1}, Dir::LEFT);
         }
+        for(int col = 0; col < columns; ++col)
+        {
+            entries.emplace_back(Pos{0, col}, Dir::DOWN);
+            entries.emplace_back(Pos{rows - 1, col}, Dir::UP);
+        }
+        return xutil::parallelReduce(
+            entries.size(), uval{},
+            [&](const std::size_t begin, const std::size_t end) {
+                uval max = 0;
+                for(auto idx = begin; idx < end; ++idx)
+                {
+                    max = std::max(max, energized(entries[idx].first,
+                                                  entries[idx].second));
+                }
+                return max;
+            },
+            [](const uval left, const uval right) {
+                return std::max(left, right);
+            });
     }
-    return result;
-}
 
-inline uval totalEnergy(const EnergizedBoard &board)
-{
-    task::uval cnt = 0;
-    for(std::size_t row = 0; row < board.rows(); ++row)
+private:
+    static constexpr auto NO_NODE =
+        std::numeric_limits<graphutil::NodeIdx>::max();
+
+    // Follows a beam entering `idx` moving in `dir` into `tiles` until it
+    // leaves the board or enters a splitter across, returning that splitter.
+    // Apart from splitters entered across every move has a single
+    // predecessor, so a path that doesn't end loops back to its start.
+    graphutil::NodeIdx trace(Size idx, Dir dir, detail::TileSet &tiles) const
     {
-        for(std::size_t col = 0; col < board.columns(); ++col)
+        const auto start = std::pair{idx, dir};
+        while(board->cells[idx] != Cell::OUTSIDE)
         {
-            cnt += board.ix(row, col);
+            tiles.set(idx);
+            const auto cell = board->cells[idx];
+            if(detail::splits(cell, dir))
+            {
+                return nodes[idx];
+            }
+            dir = static_cast<Dir>(std::countr_zero(
+                detail::TRANSITIONS[std::to_underlying(cell)]
+                                   [std::to_underlying(dir)]));
+            idx += steps[std::to_underlying(dir)];
+            if(std::pair{idx, dir} == start)
+            {
+                break;
+            }
         }
+        return NO_NODE;
     }
-    return cnt;
-}
+
+    const Board *board;
+    std::array<std::ptrdiff_t, DIRS> steps;
+    std::vector<graphutil::NodeIdx> nodes;
+    std::vector<graphutil::NodeIdx> componentOf;
+    std::vector<detail::TileSet> reached;
+};
 }
 
 #endif
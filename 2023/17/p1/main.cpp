@@ -16,16 +16,11 @@ int main()
     {
         throw std::runtime_error("invalid board: empty");
     }
-    constexpr task::uval MAX_DIRECT_STEPS = 3;
     const auto maybeCost =
         task::minPathCost(*maybeBoard, {0, 0},
                           {static_cast<int>(maybeBoard->rows()) - 1,
                            static_cast<int>(maybeBoard->columns()) - 1},
-                          [](const auto &, const auto &state) {
-                              return task::CrucibleActionMask::ROTATE |
-                                     ((state.steps < MAX_DIRECT_STEPS) *
-                                      task::CrucibleActionMask::DIRECT);
-                          });
+                          task::StepPolicy<0, 3>{});
     if(!maybeCost)
     {
         throw std::invalid_argument("no path found");
@@ -16,18 +16,11 @@ int main()
     {
         throw std::runtime_error("invalid board: empty");
     }
-    constexpr task::uval MAX_DIRECT_STEPS = 10;
-    constexpr task::uval MIN_DIRECT_STEPS = 4;
     const auto maybeCost =
         task::minPathCost(*maybeBoard, {0, 0},
                           {static_cast<int>(maybeBoard->rows()) - 1,
                            static_cast<int>(maybeBoard->columns()) - 1},
-                          [&](const auto &, const auto &state) {
-                              return ((state.steps >= MIN_DIRECT_STEPS) *
-                                      task::CrucibleActionMask::ROTATE) |
-                                     ((state.steps < MAX_DIRECT_STEPS) *
-                                      task::CrucibleActionMask::DIRECT);
-                          });
+                          task::StepPolicy<4, 10>{});
     if(!maybeCost)
     {
         throw std::invalid_argument("no path found");
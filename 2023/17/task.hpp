@@ -5,17 +5,16 @@
 #include <array>
 #include <concepts>
 #include <cstddef>
+#include <cstdint>
 #include <expected>
 #include <format>
 #include <istream>
 #include <iterator>
-#include <map>
+#include <limits>
 #include <optional>
-#include <queue>
 #include <ranges>
 #include <string>
 #include <string_view>
-#include <tuple>
 #include <type_traits>
 #include <utility>
 #include <vector>
@@ -103,126 +102,285 @@ namespace input
 
 namespace detail
 {
-    struct Cand
-    {
-        Pos pos{};
-        CrucibleState state{};
-        uval cost{};
-    };
-    class CandMore
+    constexpr std::size_t DIRS = 4;
+    // Clockwise from up, so that turning is a step of one in either way.
+    constexpr std::array<Pos, DIRS> DIR_STEPS{{
+        {-1, 0},
+        {0, 1},
+        {1, 0},
+        {0, -1},
+    }};
+    constexpr std::size_t START_DIR = 1;
+
+    using StateIdx = std::uint32_t;
+    constexpr auto UNREACHED = std::numeric_limits<uval>::max();
+
+    // Dial's queue for costs growing by at most `maxWeight` per move: a ring
+    // of buckets indexed by cost modulo its size.
+    class BucketQueue
     {
     public:
-        explicit CandMore(const Pos &dst) : dst(dst)
+        explicit BucketQueue(const uval maxWeight) : buckets(maxWeight + 1)
         {
         }
 
-        bool operator()(const Cand &left, const Cand &right) const
+        void push(const uval cost, const StateIdx state)
+        {
+            buckets[cost % buckets.size()].push_back(state);
+            ++pending;
+        }
+        [[nodiscard]] bool empty() const
+        {
+            return pending == 0;
+        }
+        // A state of the lowest cost with that cost.
+        std::pair<uval, StateIdx> pop()
         {
-            const auto orderKey = [this](const auto &cand) {
-                // dist estimate for the actual cost
-                return dist(dst, cand.pos) + cand.cost;
-            };
-            return orderKey(right) < orderKey(left);
+            while(buckets[current % buckets.size()].empty())
+            {
+                ++current;
+            }
+            auto &bucket = buckets[current % buckets.size()];
+            const auto state = bucket.back();
+            bucket.pop_back();
+            --pending;
+            return {current, state};
         }
 
     private:
-        Pos dst;
+        std::vector<std::vector<StateIdx>> buckets;
+        uval current{};
+        std::size_t pending{};
     };
 
-    struct CrucibleStateLess
+    inline uval maxCellCost(const Board &board)
     {
-        constexpr bool operator()(const CrucibleState &left,
-                                  const CrucibleState &right) const
+        uval result = 0;
+        for(std::size_t row = 0; row < board.rows(); ++row)
         {
-            return std::forward_as_tuple(left.dir, left.steps) <
-                   std::forward_as_tuple(right.dir, right.steps);
+            for(std::size_t col = 0; col < board.columns(); ++col)
+            {
+                result = std::max(result, board.ix(row, col));
+            }
         }
+        return result;
+    }
+
+    template<typename T>
+    struct IsStepPolicy : std::false_type
+    {
     };
 }
 
+// Crucible allowed to turn once it moved at least MinSteps blocks in a line
+// and required to turn after MaxSteps.
+template<uval MinSteps, uval MaxSteps>
+struct StepPolicy
+{
+    constexpr std::underlying_type_t<CrucibleActionMask> operator()(
+        const Pos &, const CrucibleState &state) const
+    {
+        return ((state.steps >= MinSteps) * CrucibleActionMask::ROTATE) |
+               ((state.steps < MaxSteps) * CrucibleActionMask::DIRECT);
+    }
+};
+
+template<uval MinSteps, uval MaxSteps>
+struct detail::IsStepPolicy<StepPolicy<MinSteps, MaxSteps>> : std::true_type
+{
+};
+
 constexpr bool isInside(const Pos &pos, const Pos &size)
 {
     return pos.r >= 0 && pos.r < size.r && pos.c >= 0 && pos.c < size.c;
 }
 
-template<typename CrucibleFunc>
-requires std::convertible_to<
-    std::invoke_result_t<CrucibleFunc, Pos, CrucibleState>,
-    std::underlying_type_t<CrucibleActionMask>>
-std::optional<uval> minPathCost(const Board &board, const Pos &src,
-                                const Pos &dst, CrucibleFunc &&steerCrucible)
+namespace detail
 {
-    constexpr task::Pos ROT_LEFT{0, 1};
-    constexpr task::Pos ROT_RIGHT{0, -1};
-    numutil::Matrix<std::map<CrucibleState, uval, detail::CrucibleStateLess>>
-        seen(board.rows(), board.columns());
-    std::priority_queue<detail::Cand, std::vector<detail::Cand>,
-                        detail::CandMore>
-        front(detail::CandMore{dst});
-    front.push(detail::Cand{
-        .pos = src,
-        .state = {.dir = {0, 1}, .steps = 0},
-        .cost = 0,
-    });
-    const Pos size{
-        static_cast<int>(board.rows()),
-        static_cast<int>(board.columns()),
-    };
-    const auto appendMove = [&](const Pos &pos, uval cost,
-                                const CrucibleState &state) {
-        if(isInside(pos, size))
+    // Searches (cell, arrival axis) states where every edge is a whole
+    // straight run, its cost read from prefix sums along the rows and
+    // columns. Like the generic search the crucible starts facing right
+    // without having moved, so it may only turn there when MinSteps is 0.
+    template<uval MinSteps, uval MaxSteps>
+    std::optional<uval> minRunPathCost(const Board &board, const Pos &src,
+                                       const Pos &dst)
+    {
+        constexpr uval MIN_RUN = std::max<uval>(MinSteps, 1);
+        const auto rows = static_cast<int>(board.rows());
+        const auto columns = static_cast<int>(board.columns());
+        if(src == dst && MinSteps == 0)
         {
-            const auto nxtCost = cost + board.ix(pos.r, pos.c);
-            const auto [iter, inserted] =
-                seen.ix(pos.r, pos.c).emplace(state, nxtCost);
-            if(inserted || nxtCost < iter->second)
-            {
-                iter->second = nxtCost;
-                front.push(detail::Cand{
-                    .pos = pos,
-                    .state = state,
-                    .cost = nxtCost,
-                });
-            }
+            return 0;
         }
-    };
-    std::optional<uval> minCost;
-    while(!front.empty())
-    {
-        const auto cur = front.top();
-        front.pop();
-        const auto actions = steerCrucible(cur.pos, cur.state);
-        if(cur.pos == dst && (actions & CrucibleActionMask::ROTATE))
+        // rowPrefix sums a row up to a cell, excluded, colPrefix a column
+        std::vector<uval> rowPrefix(board.rows() * (board.columns() + 1));
+        std::vector<uval> colPrefix(board.columns() * (board.rows() + 1));
+        for(int row = 0; row < rows; ++row)
         {
-            minCost = std::min(cur.cost, minCost.value_or(cur.cost));
-            continue;
+            for(int col = 0; col < columns; ++col)
+            {
+                const auto cost = board.ix(row, col);
+                rowPrefix[row * (columns + 1) + col + 1] =
+                    rowPrefix[row * (columns + 1) + col] + cost;
+                colPrefix[col * (rows + 1) + row + 1] =
+                    colPrefix[col * (rows + 1) + row] + cost;
+            }
         }
-        if(minCost && cur.cost >= *minCost)
+        // cost of entering the cells between `from` (excluded) and `to`
+        const auto runCost = [&](const Pos &from, const Pos &to) {
+            if(from.r == to.r)
+            {
+                const auto base = from.r * (columns + 1);
+                return (from.c < to.c ? rowPrefix[base + to.c + 1] -
+                                            rowPrefix[base + from.c + 1]
+                                      : rowPrefix[base + from.c] -
+                                            rowPrefix[base + to.c]);
+            }
+            const auto base = from.c * (rows + 1);
+            return (from.r < to.r ? colPrefix[base + to.r + 1] -
+                                        colPrefix[base + from.r + 1]
+                                  : colPrefix[base + from.r] -
+                                        colPrefix[base + to.r]);
+        };
+        std::vector<uval> costs(board.rows() * board.columns() * 2, UNREACHED);
+        BucketQueue front(maxCellCost(board) * MaxSteps);
+        const auto expand = [&](const Pos &pos, const uval cost,
+                                const std::size_t dir) {
+            const auto step = DIR_STEPS[dir];
+            for(uval run = MIN_RUN; run <= MaxSteps; ++run)
+            {
+                const auto nxt = pos + step * static_cast<int>(run);
+                if(!isInside(nxt, {rows, columns}))
+                {
+                    break;
+                }
+                const auto nxtCost = cost + runCost(pos, nxt);
+                const auto state = static_cast<StateIdx>(
+                    (nxt.r * columns + nxt.c) * 2 + dir % 2);
+                if(nxtCost < costs[state])
+                {
+                    costs[state] = nxtCost;
+                    front.push(nxtCost, state);
+                }
+            }
+        };
+        expand(src, 0, START_DIR);
+        if(MinSteps == 0)
         {
-            continue;
+            expand(src, 0, START_DIR - 1);
+            expand(src, 0, START_DIR + 1);
         }
-        if(actions & CrucibleActionMask::DIRECT)
+        while(!front.empty())
         {
-            appendMove(cur.pos + cur.state.dir, cur.cost,
-                       {
-                           .dir = cur.state.dir,
-                           .steps = cur.state.steps + 1,
-                       });
+            const auto [cost, state] = front.pop();
+            if(cost != costs[state])
+            {
+                continue;
+            }
+            const auto cell = static_cast<int>(state / 2);
+            const Pos pos{cell / columns, cell % columns};
+            if(pos == dst)
+            {
+                return cost;
+            }
+            // arrived along one axis, leaves along the other one
+            const auto turn = 1 - state % 2;
+            expand(pos, cost, turn);
+            expand(pos, cost, turn + 2);
         }
-        if(actions & CrucibleActionMask::ROTATE)
+        return std::nullopt;
+    }
+}
+
+// Dijkstra's search over dense (cell, direction, steps) states with a
+// bucket queue. The StepPolicy steering is dispatched at compile time to
+// minRunPathCost, any other steering may use every step count the board
+// allows.
+template<typename CrucibleFunc>
+requires std::convertible_to<
+    std::invoke_result_t<CrucibleFunc, Pos, CrucibleState>,
+    std::underlying_type_t<CrucibleActionMask>>
+std::optional<uval> minPathCost(const Board &board, const Pos &src,
+                                const Pos &dst, CrucibleFunc &&steerCrucible)
+{
+    if constexpr(detail::IsStepPolicy<std::remove_cvref_t<CrucibleFunc>>::value)
+    {
+        return []<uval MinSteps, uval MaxSteps>(
+                   const StepPolicy<MinSteps, MaxSteps> &, const Board &board,
+                   const Pos &src, const Pos &dst) {
+            return detail::minRunPathCost<MinSteps, MaxSteps>(board, src,
+                                                              dst);
+        }(steerCrucible, board, src, dst);
+    }
+    else
+    {
+        const Pos size{
+            static_cast<int>(board.rows()),
+            static_cast<int>(board.columns()),
+        };
+        const auto maxSteps = std::max(board.rows(), board.columns());
+        const auto stateIdx = [&](const Pos &pos, const std::size_t dir,
+                                  const uval steps) {
+            return static_cast<detail::StateIdx>(
+                ((static_cast<std::size_t>(pos.r * size.c + pos.c) *
+                      detail::DIRS +
+                  dir) *
+                 maxSteps) +
+                steps);
+        };
+        std::vector<uval> costs(board.rows() * board.columns() * detail::DIRS *
+                                    maxSteps,
+                                detail::UNREACHED);
+        detail::BucketQueue front(detail::maxCellCost(board));
+        const auto appendMove = [&](const Pos &pos, const uval cost,
+                                    const std::size_t dir, const uval steps) {
+            if(isInside(pos, size))
+            {
+                const auto nxtCost = cost + board.ix(pos.r, pos.c);
+                const auto state = stateIdx(pos, dir, steps);
+                if(nxtCost < costs[state])
+                {
+                    costs[state] = nxtCost;
+                    front.push(nxtCost, state);
+                }
+            }
+        };
+        const auto start = stateIdx(src, detail::START_DIR, 0);
+        costs[start] = 0;
+        front.push(0, start);
+        while(!front.empty())
         {
-            for(const auto &rotation : {ROT_LEFT, ROT_RIGHT})
+            const auto [cost, state] = front.pop();
+            if(cost != costs[state])
             {
-                const auto nxtDir = rotate(cur.state.dir, rotation);
-                appendMove(cur.pos + nxtDir, cur.cost,
-                           {
-                               .dir = nxtDir,
-                               .steps = 1,
-                           });
+                continue;
+            }
+            const auto steps = static_cast<uval>(state % maxSteps);
+            const auto dir = state / maxSteps % detail::DIRS;
+            const auto cell = static_cast<int>(state / maxSteps / detail::DIRS);
+            const Pos pos{cell / size.c, cell % size.c};
+            const auto actions = steerCrucible(
+                pos, CrucibleState{detail::DIR_STEPS[dir], steps});
+            if(pos == dst && (actions & CrucibleActionMask::ROTATE))
+            {
+                return cost;
+            }
+            if(actions & CrucibleActionMask::DIRECT)
+            {
+                appendMove(pos + detail::DIR_STEPS[dir], cost, dir, steps + 1);
+            }
+            if(actions & CrucibleActionMask::ROTATE)
+            {
+                for(const auto nxtDir :
+                    {(dir + 1) % detail::DIRS, (dir + 3) % detail::DIRS})
+                {
+                    appendMove(pos + detail::DIR_STEPS[nxtDir], cost, nxtDir,
+                               1);
+                }
             }
         }
+        return std::nullopt;
     }
-    return minCost;
 }
 }
 
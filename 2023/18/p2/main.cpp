@@ -2,16 +2,17 @@
 #include <iostream>
 #include <stdexcept>
 
+#include "../../intmath.hpp"
 #include "../task.hpp"
 
 int main()
 {
-    const auto maybeDigPlan = task::input::parseDigPlan<true>(std::cin);
-    if(!maybeDigPlan)
+    const auto maybeArea = task::measureLagoon<true>(std::cin);
+    if(!maybeArea)
     {
         throw std::runtime_error(
-            std::format("input parsing failed: {}", maybeDigPlan.error()));
+            std::format("input parsing failed: {}", maybeArea.error()));
     }
-    std::cout << task::calculateArea(*maybeDigPlan) << '\n';
+    std::cout << numutil::toDecimal(*maybeArea) << '\n';
     return 0;
 }
@@ -1,32 +1,25 @@
 #ifndef TASK_HPP
 #define TASK_HPP
 
-#include <algorithm>
-#include <cassert>
+#include <charconv>
 #include <cstddef>
+#include <cstdint>
 #include <expected>
 #include <format>
-#include <functional>
 #include <istream>
-#include <iterator>
-#include <map>
 #include <optional>
-#include <ranges>
-#include <regex>
-#include <set>
 #include <string>
 #include <string_view>
-#include <tuple>
+#include <system_error>
 #include <vector>
 
-#include "../base.hpp"
 #include "../geom.hpp"
-#include "../geom_plane.hpp"
 
 namespace task
 {
 using Pos = geom::Pos;
 using Size = std::size_t;
+using Area = unsigned __int128;
 
 namespace input
 {
@@ -39,13 +32,9 @@ namespace input
 
     namespace detail
     {
-        constexpr std::optional<Pos> parseDirection(std::string_view val)
+        constexpr std::optional<Pos> parseDirection(const char val)
         {
-            if(val.size() != 1)
-            {
-                return std::nullopt;
-            }
-            switch(val[0])
+            switch(val)
             {
             case 'U':
                 return Pos{-1, 0};
@@ -77,27 +66,54 @@ namespace input
             }
         }
 
+        // Whole `str` as a number, std::nullopt when anything is left over.
+        inline std::optional<Size> parseNumber(const std::string_view str,
+                                               const int base)
+        {
+            Size value{};
+            const auto [ptr, ec] = std::from_chars(
+                str.data(), str.data() + str.size(), value, base);
+            if(str.empty() || ec != std::errc{} ||
+               ptr != str.data() + str.size())
+            {
+                return std::nullopt;
+            }
+            return value;
+        }
+
+        // "D 12 (#a1b2c3)", the swapped step is encoded in the colour: five
+        // hex digits of size followed by the direction digit.
         template<bool Swapped>
         inline std::expected<DigStep, std::string> parseDigStep(
             std::string_view str)
         {
-            const std::regex digStepRegex(R"(([RLUD]) (\d+) \(#(\w+)\))");
-            std::match_results<std::string_view::const_iterator> match;
-            if(!std::regex_match(std::ranges::begin(str), std::ranges::end(str),
-                                 match, digStepRegex))
+            constexpr std::size_t SIZE_LENGTH = 5;
+            constexpr std::string_view COLOR_BEGIN = " (#";
+            if(str.size() < 2 || str[1] != ' ' || !str.ends_with(')'))
+            {
+                return std::unexpected("invalid dig step format");
+            }
+            const auto sizeEnd = str.find(COLOR_BEGIN, 2);
+            if(sizeEnd == std::string_view::npos)
+            {
+                return std::unexpected("invalid dig step format");
+            }
+            const auto color = str.substr(sizeEnd + COLOR_BEGIN.size(),
+                                          str.size() - 1 - sizeEnd -
+                                              COLOR_BEGIN.size());
+            if(color.empty())
             {
                 return std::unexpected("invalid dig step format");
             }
             if constexpr(!Swapped)
             {
-                const auto maybeDir = parseDirection(
-                    std::string_view{match[1].first, match[1].second});
+                const auto maybeDir = parseDirection(str[0]);
                 if(!maybeDir)
                 {
                     return std::unexpected("invalid dig direction");
                 }
-                const auto maybeSize = base::parseValue<Size>(
-                    std::string_view{match[2].first, match[2].second});
+                const auto maybeSize =
+                    parseNumber(str.substr(2, sizeEnd - 2), 10);
                 if(!maybeSize)
                 {
                     return std::unexpected("invalid dig size");
@@ -109,20 +125,18 @@ namespace input
             }
             else
             {
-                constexpr std::size_t sizeLength = 5;
-                std::string_view step{match[3].first, match[3].second};
-                if(step.size() != sizeLength + 1)
+                if(color.size() != SIZE_LENGTH + 1)
                 {
                     return std::unexpected(
-                        std::format("invalid dig step: val={}", step));
+                        std::format("invalid dig step: val={}", color));
                 }
                 const auto maybeSize =
-                    base::parseValue<Size>(step.substr(0, sizeLength), 16);
+                    parseNumber(color.substr(0, SIZE_LENGTH), 16);
                 if(!maybeSize)
                 {
                     return std::unexpected("invalid dig size");
                 }
-                const auto maybeDir = parseDirectionSwapped(step.back());
+                const auto maybeDir = parseDirectionSwapped(color.back());
                 if(!maybeDir)
                 {
                     return std::unexpected("invalid dig direction");
@@ -133,6 +147,33 @@ namespace input
                 };
             }
         }
+
+        // Calls `func(step)` for every line of `stream`, reusing one buffer.
+        template<bool Swapped, typename Func>
+        std::expected<void, std::string> forEachDigStep(std::istream &stream,
+                                                        Func &&func)
+        {
+            std::string line;
+            while(std::getline(stream, line))
+            {
+                if(!line.empty() && line.back() == '\r')
+                {
+                    line.pop_back();
+                }
+                if(line.empty())
+                {
+                    continue;
+                }
+                const auto maybeDigStep = parseDigStep<Swapped>(line);
+                if(!maybeDigStep)
+                {
+                    return std::unexpected(std::format(
+                        "dig step parsing failed: {}", maybeDigStep.error()));
+                }
+                func(*maybeDigStep);
+            }
+            return {};
+        }
     }
 
     template<bool Swapped = false>
@@ -140,168 +181,80 @@ namespace input
         std::istream &stream)
     {
         DigPlan plan;
-        for(const auto lineView :
-            std::ranges::subrange(std::istreambuf_iterator<char>{stream},
-                                  std::istreambuf_iterator<char>{}) |
-                std::views::lazy_split('\n'))
+        const auto result = detail::forEachDigStep<Swapped>(
+            stream, [&](const DigStep &step) { plan.push_back(step); });
+        if(!result)
         {
-            std::string line;
-            std::ranges::copy(lineView, std::back_inserter(line));
-            if(line.empty())
-            {
-                continue;
-            }
-            const auto maybeDigStep = detail::parseDigStep<Swapped>(line);
-            if(!maybeDigStep)
-            {
-                return std::unexpected(std::format(
-                    "dig step parsing failed: {}", maybeDigStep.error()));
-            }
-            plan.push_back(*maybeDigStep);
+            return std::unexpected(result.error());
         }
         return plan;
     }
 }
 
-namespace detail
+// Lagoon dug along a closed, non self-intersecting trench, measured while
+// digging: the shoelace sum gives the area enclosed by the trench centre
+// line and Pick's theorem turns it into the count of the dug out cubes,
+// A + b / 2 + 1 for a trench of length b.
+class Lagoon
 {
-    inline std::vector<Pos> traverse(const input::DigPlan &digPlan)
+public:
+    void dig(const input::DigStep &step)
     {
-        std::vector<Pos> result;
-        Pos cur{0, 0};
-        Pos prevDir{};
-        for(const auto &[dir, size] : digPlan)
-        {
-            assert(dir != prevDir);
-            assert(dir != (prevDir * Pos{-1, -1}));
-            result.push_back(cur);
-            cur =
-                cur + dir * Pos{static_cast<int>(size), static_cast<int>(size)};
-        }
-        assert((cur == Pos{0, 0}));
-        return result;
+        const auto size = static_cast<Wide>(step.size);
+        const auto nextRow = row + step.dir.r * size;
+        const auto nextCol = col + step.dir.c * size;
+        twiceArea += row * nextCol - nextRow * col;
+        row = nextRow;
+        col = nextCol;
+        boundary += size;
     }
 
-    inline auto traversePath(const input::DigPlan &digPlan)
+    [[nodiscard]] std::expected<Area, std::string> area() const
     {
-        std::set<Pos> seen;
-        std::vector<std::tuple<Pos, Pos>> path;
-        Pos cur{0, 0};
-        for(const auto &[dir, size] : digPlan)
+        if(row != 0 || col != 0)
         {
-            for(Size i = 0; i < size; ++i)
-            {
-                path.push_back({cur, dir});
-                cur = cur + dir;
-                const auto insertRes = seen.insert(cur).second;
-                assert(insertRes);
-            }
+            return std::unexpected("dig plan doesn't return to its start");
+        }
+        if(boundary == 0)
+        {
+            return 0;
         }
-        return path;
+        const auto absArea = (twiceArea < 0 ? -twiceArea : twiceArea);
+        return static_cast<Area>((absArea + boundary) / 2 + 1);
     }
-}
 
-inline Size calculateArea(const input::DigPlan &plan)
+private:
+    using Wide = __int128;
+
+    Wide row{};
+    Wide col{};
+    Wide twiceArea{};
+    Wide boundary{};
+};
+
+inline std::expected<Area, std::string> calculateArea(
+    const input::DigPlan &plan)
 {
-    const auto path = detail::traverse(plan);
-    if(path.empty())
-    {
-        return 0;
-    }
-    std::map<int, std::set<int>> rowColumns;
-    for(const auto &pos : path)
+    Lagoon lagoon;
+    for(const auto &step : plan)
     {
-        const auto inserted = rowColumns[pos.r].insert(pos.c).second;
-        assert(inserted);
+        lagoon.dig(step);
     }
-    constexpr auto calcLineArea = [](const auto &line) {
-        Size lineArea = 0;
-        Size extraArea = 0;
-        std::optional<int> prevBegin;
-        std::optional<std::tuple<int, int>> prevDivider;
-        const auto handleDivider = [&](const auto start, const auto end) {
-            if(prevBegin)
-            {
-                assert(end >= *prevBegin);
-                lineArea += end - *prevBegin + 1;
-                prevBegin.reset();
-            }
-            else
-            {
-                prevBegin = start;
-            }
-        };
-        for(const auto &[col, diff] : line)
-        {
-            if(prevDivider)
-            {
-                assert(diff != 0);
-                const auto &[prevPos, prevDiff] = *prevDivider;
-                if(prevDiff == diff)
-                {
-                    assert(col >= prevPos);
-                    if(prevBegin)
-                    {
-                        extraArea += col - prevPos + 1;
-                    }
-                    lineArea += col - prevPos + 1;
-                }
-                else
-                {
-                    handleDivider(prevPos, col);
-                }
-                prevDivider.reset();
-            }
-            else
-            {
-                if(diff == 0)
-                {
-                    handleDivider(col, col);
-                }
-                else
-                {
-                    prevDivider = {col, diff};
-                }
-            }
-        }
-        assert(!prevBegin);
-        assert(!prevDivider);
-        return lineArea - extraArea;
-    };
-    Size area = 0;
-    Size prevSize = 0;
-    std::set<int> line;
-    auto prevRow = begin(rowColumns)->first;
-    for(const auto &[row, columns] : rowColumns)
+    return lagoon.area();
+}
+
+// Measures the lagoon of the plan in `stream` without storing the plan.
+template<bool Swapped = false>
+std::expected<Area, std::string> measureLagoon(std::istream &stream)
+{
+    Lagoon lagoon;
+    const auto result = input::detail::forEachDigStep<Swapped>(
+        stream, [&](const input::DigStep &step) { lagoon.dig(step); });
+    if(!result)
     {
-        assert(columns.size() % 2 == 0);
-        const Size diff = row - prevRow;
-        area += prevSize * diff;
-        std::map<int, int> curCols;
-        std::ranges::copy(line | std::views::transform([](const auto col) {
-                              return std::pair{col, 0};
-                          }),
-                          std::inserter(curCols, end(curCols)));
-        for(const auto col : columns)
-        {
-            const auto [iter, inserted] = line.insert(col);
-            if(!inserted)
-            {
-                line.erase(iter);
-            }
-            curCols.insert_or_assign(col, inserted * 2 - 1);
-        }
-        const auto lineArea = calcLineArea(curCols);
-        area += lineArea;
-        prevSize =
-            calcLineArea(line | std::views::transform([](const auto col) {
-                             return std::pair{col, 0};
-                         }));
-        prevRow = row + 1;
+        return std::unexpected(result.error());
     }
-    assert(line.empty());
-    assert(prevSize == 0);
-    return area;
+    return lagoon.area();
 }
 }
 
@@ -2,14 +2,18 @@
 #define TASK_HPP
 
 #include <algorithm>
-#include <cassert>
+#include <array>
 #include <cctype>
 #include <cstddef>
+#include <cstdint>
 #include <expected>
 #include <format>
 #include <istream>
 #include <iterator>
+#include <limits>
+#include <optional>
 #include <ranges>
+#include <span>
 #include <string>
 #include <string_view>
 #include <tuple>
@@ -19,6 +23,8 @@
 #include <vector>
 
 #include "../base.hpp"
+#include "../interval_set.hpp"
+#include "../parallel.hpp"
 #include "../parse_stream.hpp"
 
 namespace task
@@ -74,6 +80,23 @@ namespace rule
 
     using Workflows = std::unordered_map<WorkflowName, Workflow>;
     using PartRatings = std::unordered_map<RatingName, uval>;
+
+    constexpr std::size_t RATINGS = 4;
+    constexpr std::array<std::string_view, RATINGS> RATING_NAMES{
+        "x", "m", "a", "s"};
+
+    // Ratings indexed by their slot in RATING_NAMES.
+    using Part = std::array<std::uint16_t, RATINGS>;
+
+    constexpr std::optional<std::size_t> ratingSlot(const std::string_view name)
+    {
+        const auto iter = std::ranges::find(RATING_NAMES, name);
+        if(iter == RATING_NAMES.end())
+        {
+            return std::nullopt;
+        }
+        return static_cast<std::size_t>(iter - RATING_NAMES.begin());
+    }
 }
 
 namespace input
@@ -81,13 +104,14 @@ namespace input
     struct Input
     {
         rule::Workflows workflows;
-        std::vector<rule::PartRatings> partRatings;
+        std::vector<rule::Part> parts;
     };
 
     namespace detail
     {
         template<typename T>
-        using ParseResult = std::expected<T, std::string>;
+        using ParseResult = std::expected<T, parser::ParseError>;
+        using ErrorCode = parser::ParseErrorCode;
 
         inline ParseResult<uval> parseValue(parser::ParseStream &stream)
         {
@@ -104,8 +128,7 @@ namespace input
             const auto maybeValue = base::parseValue<uval>(valStr);
             if(!maybeValue)
             {
-                return std::unexpected(
-                    std::format("value not parsed: {}", valStr));
+                return stream.fail(ErrorCode::INVALID_VALUE, "value");
             }
             return *maybeValue;
         }
@@ -124,7 +147,7 @@ namespace input
             }
             if(result.empty())
             {
-                return std::unexpected("empty name");
+                return stream.fail(ErrorCode::EMPTY_TOKEN, "name");
             }
             return result;
         }
@@ -141,11 +164,12 @@ namespace input
                 case '>':
                     return rule::Operation::GREATER;
                 default:
-                    return std::unexpected(
-                        std::format("invalid operation: {}", *maybeOp));
+                    return stream.fail(ErrorCode::UNEXPECTED_CHARACTER,
+                                       "condition operation");
                 }
             }
-            return std::unexpected("condition operation missing");
+            return stream.fail(ErrorCode::UNEXPECTED_END,
+                               "condition operation");
         }
 
         inline ParseResult<rule::Condition> parseCondition(
@@ -154,20 +178,17 @@ namespace input
             auto maybeName = parseName(stream);
             if(!maybeName)
             {
-                return std::unexpected(std::format(
-                    "condition name parse failed: {}", maybeName.error()));
+                return std::unexpected(maybeName.error());
             }
             const auto maybeOperation = parseOperation(stream);
             if(!maybeOperation)
             {
-                return std::unexpected(std::format("operation parse failed: {}",
-                                                   maybeOperation.error()));
+                return std::unexpected(maybeOperation.error());
             }
             const auto maybeValue = parseValue(stream);
             if(!maybeValue)
             {
-                return std::unexpected(
-                    std::format("value parse failed: {}", maybeValue.error()));
+                return std::unexpected(maybeValue.error());
             }
             return rule::Condition{
                 .operation = *maybeOperation,
@@ -182,8 +203,7 @@ namespace input
             auto maybeName = parseName(stream);
             if(!maybeName)
             {
-                return std::unexpected(
-                    std::format("name parsing failed: {}", maybeName.error()));
+                return std::unexpected(maybeName.error());
             }
             if(*maybeName == "R")
             {
@@ -201,19 +221,18 @@ namespace input
             auto maybeCondition = parseCondition(stream);
             if(!maybeCondition)
             {
-                return std::unexpected(std::format("condition parse failed: {}",
-                                                   maybeCondition.error()));
+                return std::unexpected(maybeCondition.error());
             }
-            if(const auto maybeSep = stream.read();
-               !maybeSep || *maybeSep != ':')
+            if(const auto maybeSep = stream.read(); maybeSep != ':')
             {
-                return std::unexpected("invalid condition separator");
+                return stream.fail(maybeSep ? ErrorCode::UNEXPECTED_CHARACTER
+                                            : ErrorCode::UNEXPECTED_END,
+                                   "condition separator");
             }
             auto maybeDestination = parseDestination(stream);
             if(!maybeDestination)
             {
-                return std::unexpected(std::format(
-                    "destination parse failed: {}", maybeDestination.error()));
+                return std::unexpected(maybeDestination.error());
             }
             return rule::Rule{
                 .condition = std::move(*maybeCondition),
@@ -232,10 +251,12 @@ namespace input
                 {
                     workflow.rules.push_back(std::move(*maybeRule));
                     stream = ruleStream;
-                    if(const auto maybeSep = stream.read();
-                       !maybeSep || *maybeSep != ',')
+                    if(const auto maybeSep = stream.read(); maybeSep != ',')
                     {
-                        return std::unexpected("invalid rule separator");
+                        return stream.fail(
+                            maybeSep ? ErrorCode::UNEXPECTED_CHARACTER
+                                     : ErrorCode::UNEXPECTED_END,
+                            "rule separator");
                     }
                 }
                 else
@@ -243,9 +264,7 @@ namespace input
                     auto maybeDestination = parseDestination(stream);
                     if(!maybeDestination)
                     {
-                        return std::unexpected(
-                            std::format("workflow parsing failed: {}",
-                                        maybeDestination.error()));
+                        return std::unexpected(maybeDestination.error());
                     }
                     workflow.defaultDestination = std::move(*maybeDestination);
                     break;
@@ -260,31 +279,32 @@ namespace input
             auto maybeName = parseName(stream);
             if(!maybeName)
             {
-                return std::unexpected(std::format(
-                    "workflow name parsing failed: {}", maybeName.error()));
+                return std::unexpected(maybeName.error());
             }
             if(const auto maybeWorkflowStart = stream.read();
-               !maybeWorkflowStart || *maybeWorkflowStart != '{')
+               maybeWorkflowStart != '{')
             {
-                return std::unexpected(std::format(
-                    "no workflow start character: {}",
-                    maybeWorkflowStart ? std::string(1, *maybeWorkflowStart)
-                                       : "<null>"));
+                return stream.fail(maybeWorkflowStart
+                                       ? ErrorCode::UNEXPECTED_CHARACTER
+                                       : ErrorCode::UNEXPECTED_END,
+                                   "workflow start");
             }
             const auto maybeWorkflow = parseWorkflow(stream);
             if(!maybeWorkflow)
             {
-                return std::unexpected(std::format(
-                    "workflow parsing failed: {}", maybeWorkflow.error()));
+                return std::unexpected(maybeWorkflow.error());
             }
             if(const auto maybeWorkflowEnd = stream.read();
-               !maybeWorkflowEnd || *maybeWorkflowEnd != '}')
+               maybeWorkflowEnd != '}')
             {
-                return std::unexpected("no workflow end character");
+                return stream.fail(maybeWorkflowEnd
+                                       ? ErrorCode::UNEXPECTED_CHARACTER
+                                       : ErrorCode::UNEXPECTED_END,
+                                   "workflow end");
             }
             if(const auto maybeEos = stream.peek(); maybeEos)
             {
-                return std::unexpected("unexpected workflow end");
+                return stream.fail(ErrorCode::TRAILING_CHARACTERS, "workflow");
             }
             return std::tuple{std::move(*maybeName), std::move(*maybeWorkflow)};
         }
@@ -295,19 +315,18 @@ namespace input
             auto maybeName = parseName(stream);
             if(!maybeName)
             {
-                return std::unexpected(std::format(
-                    "rating name parse failed: {}", maybeName.error()));
+                return std::unexpected(maybeName.error());
             }
-            if(const auto maybeSep = stream.read();
-               !maybeSep || *maybeSep != '=')
+            if(const auto maybeSep = stream.read(); maybeSep != '=')
             {
-                return std::unexpected("invalid rating separator");
+                return stream.fail(maybeSep ? ErrorCode::UNEXPECTED_CHARACTER
+                                            : ErrorCode::UNEXPECTED_END,
+                                   "rating separator");
             }
             const auto maybeValue = parseValue(stream);
             if(!maybeValue)
             {
-                return std::unexpected(std::format("invalid rating value: {}",
-                                                   maybeValue.error()));
+                return std::unexpected(maybeValue.error());
             }
             return std::tuple{std::move(*maybeName), *maybeValue};
         }
@@ -315,10 +334,11 @@ namespace input
         inline ParseResult<rule::PartRatings> parsePartRating(
             parser::ParseStream &stream)
         {
-            if(const auto maybeBegin = stream.read();
-               !maybeBegin || *maybeBegin != '{')
+            if(const auto maybeBegin = stream.read(); maybeBegin != '{')
             {
-                return std::unexpected("invalid ratings begin");
+                return stream.fail(maybeBegin ? ErrorCode::UNEXPECTED_CHARACTER
+                                              : ErrorCode::UNEXPECTED_END,
+                                   "ratings begin");
             }
             rule::PartRatings ratings;
             bool first = true;
@@ -350,37 +370,62 @@ namespace input
                         break;
                     }
                     stream = ratingStream;
-                    return std::unexpected(std::format(
-                        "rating parsing failed: {}", maybeRating.error()));
+                    return std::unexpected(maybeRating.error());
                 }
                 first = false;
             }
-            if(const auto maybeEnd = stream.read();
-               !maybeEnd || *maybeEnd != '}')
+            if(const auto maybeEnd = stream.read(); maybeEnd != '}')
             {
-                return std::unexpected("invalid ratings end");
+                return stream.fail(maybeEnd ? ErrorCode::UNEXPECTED_CHARACTER
+                                            : ErrorCode::UNEXPECTED_END,
+                                   "ratings end");
             }
             if(const auto maybeEos = stream.peek(); maybeEos)
             {
-                return std::unexpected("ratings extra characters");
+                return stream.fail(ErrorCode::TRAILING_CHARACTERS, "ratings");
             }
             return ratings;
         }
 
-        inline std::expected<std::tuple<rule::WorkflowName, rule::Workflow>,
-                             std::string>
+        inline ParseResult<std::tuple<rule::WorkflowName, rule::Workflow>>
         parseWorkflow(std::string_view str)
         {
             parser::ParseStream stream(str);
             return parseNamedWorkflow(stream);
         }
 
-        inline std::expected<rule::PartRatings, std::string> parsePartRatings(
+        inline ParseResult<rule::PartRatings> parsePartRatings(
             std::string_view str)
         {
             parser::ParseStream stream(str);
             return parsePartRating(stream);
         }
+
+        inline std::expected<rule::Part, std::string> packPart(
+            const rule::PartRatings &ratings)
+        {
+            rule::Part part{};
+            if(ratings.size() != rule::RATINGS)
+            {
+                return std::unexpected("expected x, m, a and s ratings");
+            }
+            for(const auto &[name, value] : ratings)
+            {
+                const auto maybeSlot = rule::ratingSlot(name);
+                if(!maybeSlot)
+                {
+                    return std::unexpected(
+                        std::format("unknown rating: {}", name));
+                }
+                if(value > std::numeric_limits<rule::Part::value_type>::max())
+                {
+                    return std::unexpected(
+                        std::format("rating out of range: {}", value));
+                }
+                part[*maybeSlot] = static_cast<rule::Part::value_type>(value);
+            }
+            return part;
+        }
     }
 
     inline std::expected<Input, std::string> parseInput(std::istream &stream)
@@ -397,13 +442,13 @@ namespace input
             auto maybeWorkflow = detail::parseWorkflow(line);
             if(!maybeWorkflow)
             {
-                return std::unexpected(
-                    std::format("invalid workflow: {}", maybeWorkflow.error()));
+                return std::unexpected(std::format(
+                    "invalid workflow: {}", maybeWorkflow.error().message()));
             }
             workflows.emplace(std::move(std::get<0>(*maybeWorkflow)),
                               std::move(std::get<1>(*maybeWorkflow)));
         }
-        std::vector<rule::PartRatings> partRatings;
+        std::vector<rule::Part> parts;
         while(stream)
         {
             std::string line;
@@ -414,320 +459,462 @@ namespace input
             }
             auto maybePartRatings = detail::parsePartRatings(line);
             if(!maybePartRatings)
+            {
+                return std::unexpected(
+                    std::format("invalid part ratings: {}",
+                                maybePartRatings.error().message()));
+            }
+            const auto maybePart = detail::packPart(*maybePartRatings);
+            if(!maybePart)
             {
                 return std::unexpected(std::format("invalid part ratings: {}",
-                                                   maybePartRatings.error()));
+                                                   maybePart.error()));
             }
-            partRatings.push_back(std::move(*maybePartRatings));
+            parts.push_back(*maybePart);
         }
-        return Input{std::move(workflows), std::move(partRatings)};
+        return Input{std::move(workflows), std::move(parts)};
     }
 }
 
-class Range
+namespace detail
 {
-public:
-    struct JoinResult
+    // Jumps to `target` when (part[slot] < value) != negate, a rating
+    // greater than v being one not less than v + 1. The fallback of a
+    // workflow is a negated comparison with 0, which always jumps.
+    struct Instruction
     {
-        std::vector<Range> left;
-        std::vector<Range> right;
-        std::vector<Range> common;
+        std::uint32_t value{};
+        std::uint32_t target{};
+        std::uint8_t slot{};
+        bool negate{};
     };
 
-    constexpr Range(uval begin, uval end) : begin(begin), end(end)
-    {
-    }
+    constexpr auto ACCEPT = std::numeric_limits<std::uint32_t>::max();
+    constexpr auto REJECT = ACCEPT - 1;
 
-    constexpr uval b() const
-    {
-        return begin;
-    }
-    constexpr uval e() const
-    {
-        return end;
-    }
+    constexpr std::size_t PART_LANES = 8;
 
-    friend auto operator<=>(const Range &, const Range &) = default;
+    enum class Mark : std::uint8_t
+    {
+        OPEN,
+        DONE,
+    };
 
-    constexpr friend JoinResult join(const Range &left, const Range &right)
+    // The workflows reachable from a start one, each after all of its
+    // destinations, the start one last.
+    struct PostOrder
     {
-        if(left > right)
-        {
-            auto res = join(right, left);
-            return {
-                .left = std::move(res.right),
-                .right = std::move(res.left),
-                .common = std::move(res.common),
-            };
-        }
-        if(left.end < right.begin)
-        {
-            return {
-                .left = {left},
-                .right = {right},
-                .common = {},
-            };
-        }
-        if(left == right)
+        std::vector<const rule::Workflow *> workflows;
+        std::unordered_map<std::string_view, std::uint32_t> positions;
+
+        [[nodiscard]] std::uint32_t position(
+            const rule::DestinationWorkflow &dst) const
         {
-            return {
-                .left = {},
-                .right = {},
-                .common = {left},
-            };
+            return positions.at(dst.name);
         }
-        if(left.begin == right.begin)
+    };
+
+    // Depth first with an explicit stack, rejecting missing workflows and
+    // cycles, which would never finish.
+    inline std::expected<PostOrder, std::string> postOrder(
+        const rule::Workflows &workflows,
+        const rule::WorkflowName &startWorkflow)
+    {
+        struct Frame
         {
-            return {
-                .left = {},
-                .right = {Range(left.end + 1, right.end)},
-                .common = {Range(left.begin, left.end)},
-            };
-        }
-        if(left.end == right.end)
+            const rule::WorkflowName *name{};
+            const rule::Workflow *workflow{};
+            std::size_t next{};
+        };
+        std::unordered_map<std::string_view, Mark> marks;
+        std::vector<Frame> frames;
+        PostOrder result;
+        const auto open = [&](const rule::WorkflowName &name)
+            -> std::expected<void, std::string> {
+            const auto iter = workflows.find(name);
+            if(iter == end(workflows))
+            {
+                return std::unexpected(
+                    std::format("workflow not found: {}", name));
+            }
+            const auto [markIter, inserted] =
+                marks.try_emplace(iter->first, Mark::OPEN);
+            if(!inserted)
+            {
+                if(markIter->second == Mark::OPEN)
+                {
+                    return std::unexpected(
+                        std::format("workflow cycle through: {}", name));
+                }
+                return {};
+            }
+            frames.push_back({&iter->first, &iter->second, 0});
+            return {};
+        };
+        if(auto status = open(startWorkflow); !status)
         {
-            return {
-                .left = {Range(left.begin, right.begin - 1)},
-                .right = {},
-                .common = {Range(right.begin, right.end)},
-            };
+            return std::unexpected(std::move(status.error()));
         }
-        if(left.end > right.end)
+        while(!frames.empty())
         {
-            return {
-                .left = {Range(left.begin, right.begin - 1),
-                         Range(right.end + 1, left.end)},
-                .right = {},
-                .common = {Range(right.begin, right.end)},
-            };
+            auto &frame = frames.back();
+            const auto &workflow = *frame.workflow;
+            if(frame.next <= workflow.rules.size())
+            {
+                const auto &dst = (frame.next < workflow.rules.size()
+                                       ? workflow.rules[frame.next].destination
+                                       : workflow.defaultDestination);
+                ++frame.next;
+                if(const auto *workflowDst =
+                       std::get_if<rule::DestinationWorkflow>(&dst))
+                {
+                    if(auto status = open(workflowDst->name); !status)
+                    {
+                        return std::unexpected(std::move(status.error()));
+                    }
+                }
+                continue;
+            }
+            marks[*frame.name] = Mark::DONE;
+            result.positions.emplace(
+                *frame.name,
+                static_cast<std::uint32_t>(result.workflows.size()));
+            result.workflows.push_back(&workflow);
+            frames.pop_back();
         }
-        return {
-            .left = {Range(left.begin, right.begin - 1)},
-            .right = {Range(left.end + 1, right.end)},
-            .common = {Range(right.begin, left.end)},
-        };
+        return result;
     }
 
-    friend constexpr std::vector<Range> common(const Range &left,
-                                               const Range &right)
+    inline std::expected<std::size_t, std::string> conditionSlot(
+        const rule::Condition &cond)
     {
-        if(left > right)
-        {
-            return common(right, left);
-        }
-        if(left.end < right.begin)
-        {
-            return {left, right};
-        }
-        if(left.end >= right.end)
+        const auto maybeSlot = rule::ratingSlot(cond.name);
+        if(!maybeSlot)
         {
-            return {left};
+            return std::unexpected(
+                std::format("unknown rating: {}", cond.name));
         }
-        return {Range(left.begin, right.end)};
+        return *maybeSlot;
     }
+}
 
-    friend constexpr std::optional<Range> intersect(const Range &left,
-                                                    const Range &right)
+// Workflows compiled into flat code, the destinations resolved to code
+// offsets and the ratings to slots.
+class WorkflowProgram
+{
+public:
+    WorkflowProgram(std::vector<detail::Instruction> code,
+                    const std::uint32_t entry)
+        : code(std::move(code)), entry(entry)
     {
-        if(left > right)
-        {
-            return intersect(right, left);
-        }
-        if(left.end < right.begin)
+    }
+
+    [[nodiscard]] rule::Action run(const rule::Part &part) const
+    {
+        auto pc = entry;
+        while(pc < detail::REJECT)
         {
-            return std::nullopt;
+            const auto &ins = code[pc];
+            const bool taken = (part[ins.slot] < ins.value) != ins.negate;
+            pc = (taken ? ins.target : pc + 1);
         }
-        return Range(right.begin, std::min(left.end, right.end));
+        return (pc == detail::ACCEPT ? rule::Action::ACCEPT
+                                     : rule::Action::REJECT);
+    }
+
+    // Sum of the ratings of the accepted `parts`. Every worker runs
+    // PART_LANES parts in lockstep over a transposed block of their
+    // ratings, so that their independent jumps overlap.
+    [[nodiscard]] ulval acceptedRatingSum(
+        const std::span<const rule::Part> parts) const
+    {
+        constexpr auto LANES = detail::PART_LANES;
+        return xutil::parallelReduce(
+            parts.size(), ulval{},
+            [&](const std::size_t begin, const std::size_t end) {
+                ulval sum = 0;
+                for(auto first = begin; first < end; first += LANES)
+                {
+                    const auto count = std::min(LANES, end - first);
+                    std::array<std::array<std::uint16_t, LANES>, rule::RATINGS>
+                        block{};
+                    std::array<std::uint32_t, LANES> pcs{};
+                    pcs.fill(detail::REJECT);
+                    for(std::size_t lane = 0; lane < count; ++lane)
+                    {
+                        for(std::size_t slot = 0; slot < rule::RATINGS; ++slot)
+                        {
+                            block[slot][lane] = parts[first + lane][slot];
+                        }
+                        pcs[lane] = entry;
+                    }
+                    for(bool running = true; running;)
+                    {
+                        running = false;
+                        for(std::size_t lane = 0; lane < LANES; ++lane)
+                        {
+                            const auto pc = pcs[lane];
+                            if(pc >= detail::REJECT)
+                            {
+                                continue;
+                            }
+                            const auto &ins = code[pc];
+                            const bool taken =
+                                (block[ins.slot][lane] < ins.value) !=
+                                ins.negate;
+                            pcs[lane] = (taken ? ins.target : pc + 1);
+                            running = true;
+                        }
+                    }
+                    for(std::size_t lane = 0; lane < count; ++lane)
+                    {
+                        if(pcs[lane] == detail::ACCEPT)
+                        {
+                            for(std::size_t slot = 0; slot < rule::RATINGS;
+                                ++slot)
+                            {
+                                sum += block[slot][lane];
+                            }
+                        }
+                    }
+                }
+                return sum;
+            });
     }
 
 private:
-    uval begin;
-    uval end;
+    std::vector<detail::Instruction> code;
+    std::uint32_t entry{};
 };
-using RangeDict = std::unordered_map<std::string, Range>;
 
-struct SolveParam
+// Compiles the workflows reachable from `startWorkflow`, each one after its
+// destinations so that their code offsets are known.
+inline std::expected<WorkflowProgram, std::string> compileWorkflows(
+    const rule::Workflows &workflows, const rule::WorkflowName &startWorkflow)
 {
-    std::vector<rule::RatingName> names;
-    Range fullRange;
-};
+    const auto maybeOrder = detail::postOrder(workflows, startWorkflow);
+    if(!maybeOrder)
+    {
+        return std::unexpected(maybeOrder.error());
+    }
+    std::vector<std::uint32_t> entries;
+    std::vector<detail::Instruction> code;
+    const auto resolve = [&](const rule::Destination &dst) {
+        if(const auto *actionDst = std::get_if<rule::DestinationAction>(&dst))
+        {
+            return (actionDst->action == rule::Action::ACCEPT ? detail::ACCEPT
+                                                              : detail::REJECT);
+        }
+        return entries[maybeOrder->position(
+            std::get<rule::DestinationWorkflow>(dst))];
+    };
+    for(const auto *workflow : maybeOrder->workflows)
+    {
+        entries.push_back(static_cast<std::uint32_t>(code.size()));
+        for(const auto &curRule : workflow->rules)
+        {
+            const auto &cond = curRule.condition;
+            const auto maybeSlot = detail::conditionSlot(cond);
+            if(!maybeSlot)
+            {
+                return std::unexpected(maybeSlot.error());
+            }
+            constexpr std::uint32_t LIMIT =
+                std::numeric_limits<rule::Part::value_type>::max() + 1U;
+            const auto bound = std::min<std::uint32_t>(cond.value, LIMIT - 1);
+            const bool greater = cond.operation == rule::Operation::GREATER;
+            code.push_back({
+                .value = (greater ? bound + 1 : std::min(cond.value, LIMIT)),
+                .target = resolve(curRule.destination),
+                .slot = static_cast<std::uint8_t>(*maybeSlot),
+                .negate = greater,
+            });
+        }
+        code.push_back({
+            .value = 0,
+            .target = resolve(workflow->defaultDestination),
+            .slot = 0,
+            .negate = true,
+        });
+    }
+    return WorkflowProgram(std::move(code), entries.back());
+}
+
+using Range = xutil::Interval<uval>;
+// Ratings accepted together, a range per slot.
+using Box = std::array<Range, rule::RATINGS>;
 
 namespace detail
 {
-    inline std::vector<RangeDict> solveWorkflow(
-        const rule::WorkflowName &name, const rule::Workflows &workflows,
-        const SolveParam &params);
+    inline ulval volume(const Box &box)
+    {
+        ulval result = 1;
+        for(const auto &range : box)
+        {
+            result *= range.length();
+        }
+        return result;
+    }
 
-    inline std::vector<RangeDict> solveDestination(
-        const rule::Destination &dst, const rule::Workflows &workflows,
-        const SolveParam &param)
+    inline bool sameOutside(const Box &left, const Box &right,
+                            const std::size_t slot)
     {
-        if(const auto *const actionDst =
-               std::get_if<rule::DestinationAction>(&dst))
+        for(std::size_t other = 0; other < rule::RATINGS; ++other)
         {
-            switch(actionDst->action)
+            if(other != slot && left[other] != right[other])
             {
-            case rule::Action::REJECT:
-                return {};
-            case rule::Action::ACCEPT: {
-                auto resView =
-                    param.names | std::views::transform([&](const auto &name) {
-                        return std::pair{name, param.fullRange};
-                    });
-                return {RangeDict{std::ranges::begin(resView),
-                                  std::ranges::end(resView)}};
+                return false;
             }
-            }
-            std::unreachable();
         }
-        if(const auto *const workflowDst =
-               std::get_if<rule::DestinationWorkflow>(&dst))
+        return true;
+    }
+
+    // Merges disjoint boxes equal in all slots but one where their ranges
+    // abut, until no two can be merged. A workflow sending both sides of a
+    // split to the same place gets back the boxes it started from instead
+    // of twice as many pieces, so shared chains don't multiply them.
+    inline void coalesce(std::vector<Box> &boxes)
+    {
+        for(bool merged = true; merged;)
         {
-            return solveWorkflow(workflowDst->name, workflows, param);
+            merged = false;
+            for(std::size_t slot = 0; slot < rule::RATINGS; ++slot)
+            {
+                // boxes differing only in `slot` end up next to each other
+                std::ranges::sort(boxes, {}, [slot](Box box) {
+                    std::swap(box[slot], box.back());
+                    return box;
+                });
+                std::size_t kept = 0;
+                for(std::size_t idx = 0; idx < boxes.size(); ++idx)
+                {
+                    if(kept != 0)
+                    {
+                        auto &last = boxes[kept - 1];
+                        if(last[slot].end == boxes[idx][slot].begin &&
+                           sameOutside(last, boxes[idx], slot))
+                        {
+                            last[slot].end = boxes[idx][slot].end;
+                            merged = true;
+                            continue;
+                        }
+                    }
+                    boxes[kept++] = boxes[idx];
+                }
+                boxes.resize(kept);
+            }
         }
-        std::unreachable();
     }
 
-    inline std::vector<RangeDict> solveWorkflow(
-        const rule::WorkflowName &name, const rule::Workflows &workflows,
-        const SolveParam &params)
+    // Calls `func(box)` for the disjoint boxes of `full` accepted by
+    // `workflow`, the boxes of a destination workflow read from `accepted`
+    // and clipped to the rule region. A rule condition splits the region
+    // left by the previous rules into two boxes, matched and not matched.
+    template<typename Func>
+    std::expected<void, std::string> forEachAccepted(
+        const rule::Workflow &workflow, const Box &full,
+        const PostOrder &order, const std::vector<std::vector<Box>> &accepted,
+        Func &&func)
     {
-        const auto condRange = [&](const auto &cond) {
-            switch(cond.operation)
+        const auto visit = [&](const rule::Destination &dst,
+                               const Box &region) {
+            if(const auto *actionDst =
+                   std::get_if<rule::DestinationAction>(&dst))
             {
-            case rule::Operation::LESS:
-                return Range(params.fullRange.b(), cond.value - 1);
-            case rule::Operation::GREATER:
-                return Range(cond.value + 1, params.fullRange.e());
+                if(actionDst->action == rule::Action::ACCEPT)
+                {
+                    func(region);
+                }
+                return;
             }
-            std::unreachable();
-        };
-        const auto workflowIter = workflows.find(name);
-        if(workflowIter == end(workflows))
-        {
-            return {};
-        }
-        const auto &workflow = workflowIter->second;
-        struct ConditionRange
-        {
-            rule::RatingName name;
-            Range range;
-        };
-        std::vector<ConditionRange> targetRanges;
-        std::vector<RangeDict> result;
-        const auto solveDstRules = [&](const auto &dst) {
-            for(auto &cand : solveDestination(dst, workflows, params))
+            for(const auto &box : accepted[order.position(
+                    std::get<rule::DestinationWorkflow>(dst))])
             {
-                bool valid = true;
-                for(const auto &targetRange : targetRanges)
+                Box common{};
+                bool empty = false;
+                for(std::size_t slot = 0; slot < rule::RATINGS && !empty;
+                    ++slot)
                 {
-                    auto &candRng = cand.at(targetRange.name);
-                    if(const auto maybeIntersectRng =
-                           intersect(targetRange.range, candRng))
-                    {
-                        candRng = *maybeIntersectRng;
-                    }
-                    else
-                    {
-                        valid = false;
-                        break;
-                    }
+                    common[slot] = xutil::intersect(box[slot], region[slot]);
+                    empty = common[slot].empty();
                 }
-                if(valid)
+                if(!empty)
                 {
-                    result.push_back(std::move(cand));
+                    func(common);
                 }
             }
         };
+        auto rest = full;
         for(const auto &curRule : workflow.rules)
         {
-            targetRanges.push_back({
-                .name = curRule.condition.name,
-                .range = condRange(curRule.condition),
-            });
-            solveDstRules(curRule.destination);
-            const auto [leftInv, rightInv, commonInv] =
-                join(targetRanges.back().range, params.fullRange);
-            targetRanges.pop_back();
-            for(const auto &inv : rightInv)
-            {
-                targetRanges.push_back({
-                    .name = curRule.condition.name,
-                    .range = inv,
-                });
+            const auto &cond = curRule.condition;
+            const auto maybeSlot = conditionSlot(cond);
+            if(!maybeSlot)
+            {
+                return std::unexpected(maybeSlot.error());
+            }
+            auto &range = rest[*maybeSlot];
+            const auto split = static_cast<uval>(std::clamp<ulval>(
+                static_cast<ulval>(cond.value) +
+                    (cond.operation == rule::Operation::GREATER),
+                range.begin, range.end));
+            const Range below{range.begin, split};
+            const Range above{split, range.end};
+            auto matched = rest;
+            matched[*maybeSlot] =
+                (cond.operation == rule::Operation::LESS ? below : above);
+            range = (cond.operation == rule::Operation::LESS ? above : below);
+            if(!matched[*maybeSlot].empty())
+            {
+                visit(curRule.destination, matched);
+            }
+            if(range.empty())
+            {
+                return {};
             }
         }
-        solveDstRules(workflow.defaultDestination);
-        return result;
+        visit(workflow.defaultDestination, rest);
+        return {};
     }
 }
 
-inline std::vector<RangeDict> solve(const rule::Workflows &workflows,
-                                    const SolveParam &params,
-                                    const rule::WorkflowName &startWorkflow)
+// Number of the rating combinations in `full` accepted from
+// `startWorkflow`. The accepted boxes of every other workflow are solved
+// once, after its destinations, coalesced, and shared by all the rules
+// reaching it; the start workflow's boxes are only summed.
+inline std::expected<ulval, std::string> acceptedCombinations(
+    const rule::Workflows &workflows, const rule::WorkflowName &startWorkflow,
+    const Range &fullRange)
 {
-    return detail::solveWorkflow(startWorkflow, workflows, params);
-}
-
-inline std::expected<rule::Action, std::string> execute(
-    const rule::PartRatings &ratings, const rule::Workflows &workflows,
-    const rule::WorkflowName &startWorkflow)
-{
-    auto workflow = startWorkflow;
-    const auto execCond = [](const auto val, const auto &condition) {
-        switch(condition.operation)
-        {
-        case rule::Operation::LESS:
-            return val < condition.value;
-        case rule::Operation::GREATER:
-            return val > condition.value;
-        }
-        assert(false);
-        return false;
-    };
-    const auto matchRule = [&](const auto &ratings, const auto &rule) {
-        const auto &cond = rule.condition;
-        const auto valIter = ratings.find(cond.name);
-        if(valIter == end(ratings))
-        {
-            return false;
-        }
-        return execCond(valIter->second, cond);
-    };
-    while(true)
+    const auto maybeOrder = detail::postOrder(workflows, startWorkflow);
+    if(!maybeOrder)
     {
-        const auto iter = workflows.find(workflow);
-        if(iter == end(workflows))
-        {
-            return std::unexpected(
-                std::format("workflow not found: {}", workflow));
-        }
-        const auto matchIter =
-            std::ranges::find_if(iter->second.rules, [&](const auto &rule) {
-                return matchRule(ratings, rule);
-            });
-        const auto dst = [&] {
-            if(matchIter != std::ranges::end(iter->second.rules))
-            {
-                return matchIter->destination;
-            }
-            return iter->second.defaultDestination;
-        }();
-        if(const auto *workflowDst =
-               std::get_if<rule::DestinationWorkflow>(&dst))
-        {
-            workflow = workflowDst->name;
-        }
-        else if(const auto *actionDst =
-                    std::get_if<rule::DestinationAction>(&dst))
-        {
-            return actionDst->action;
-        }
-        else
+        return std::unexpected(maybeOrder.error());
+    }
+    Box full{};
+    full.fill(fullRange);
+    const auto &order = maybeOrder->workflows;
+    std::vector<std::vector<Box>> accepted(order.size());
+    for(std::size_t idx = 0; idx + 1 < order.size(); ++idx)
+    {
+        auto status = detail::forEachAccepted(
+            *order[idx], full, *maybeOrder, accepted,
+            [&](const Box &box) { accepted[idx].push_back(box); });
+        if(!status)
         {
-            assert(false);
+            return std::unexpected(std::move(status.error()));
         }
+        detail::coalesce(accepted[idx]);
+    }
+    ulval result = 0;
+    auto status = detail::forEachAccepted(
+        *order.back(), full, *maybeOrder, accepted,
+        [&](const Box &box) { result += detail::volume(box); });
+    if(!status)
+    {
+        return std::unexpected(std::move(status.error()));
     }
+    return result;
 }
 }
 
@@ -1,11 +1,7 @@
-#include <algorithm>
 #include <format>
-#include <functional>
 #include <iostream>
-#include <ranges>
 #include <stdexcept>
 #include <string>
-#include <unordered_map>
 
 #include "../task.hpp"
 
@@ -18,21 +14,15 @@ int main()
                                              maybeConfiguration.error()));
     }
     const std::string rootName("broadcaster");
-    task::network::Network network(*maybeConfiguration, rootName);
+    task::network::PulseEngine engine(*maybeConfiguration, rootName);
     constexpr task::uval presses = 1000;
-    std::unordered_map<task::network::Signal, task::ulval> counts;
+    task::network::PulseCounts counts;
     for(task::uval i = 0; i < presses; ++i)
     {
-        network.exec(task::network::Signal::LOW,
-                     [&counts](const auto &, const auto signal) {
-                         counts[signal] += 1;
-                         return true;
-                     });
+        const auto pressCounts = engine.press();
+        counts.low += pressCounts.low;
+        counts.high += pressCounts.high;
     }
-    std::cout << std::ranges::fold_left(
-                     counts | std::views::transform(
-                                  [](const auto &p) { return p.second; }),
-                     static_cast<task::ulval>(1), std::multiplies<>{})
-              << '\n';
+    std::cout << counts.low * counts.high << '\n';
     return 0;
 }
@@ -2,22 +2,25 @@
 #define TASK_HPP
 
 #include <algorithm>
-#include <cassert>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
 #include <expected>
 #include <format>
-#include <functional>
 #include <istream>
 #include <iterator>
-#include <memory>
-#include <optional>
-#include <queue>
+#include <limits>
+#include <numeric>
 #include <ranges>
+#include <span>
 #include <string>
+#include <string_view>
 #include <unordered_map>
-#include <unordered_set>
 #include <utility>
 #include <vector>
 
+#include "../graph_scc.hpp"
 #include "../parse_stream.hpp"
 
 namespace task
@@ -57,7 +60,8 @@ namespace input
     namespace detail
     {
         template<typename T>
-        using ParseResult = std::expected<T, std::string>;
+        using ParseResult = std::expected<T, parser::ParseError>;
+        using ErrorCode = parser::ParseErrorCode;
 
         inline ParseResult<std::string> parseName(parser::ParseStream &stream)
         {
@@ -73,7 +77,7 @@ namespace input
             }
             if(result.empty())
             {
-                return std::unexpected("empty name");
+                return stream.fail(ErrorCode::EMPTY_TOKEN, "name");
             }
             return result;
         }
@@ -84,9 +88,7 @@ namespace input
             auto maybeName = parseName(stream);
             if(!maybeName)
             {
-                return std::unexpected(
-                    std::format("broadcaster module name parsing failed: {}",
-                                maybeName.error()));
+                return std::unexpected(maybeName.error());
             }
             return Module{
                 .name = std::move(*maybeName),
@@ -100,7 +102,7 @@ namespace input
             const auto maybeType = stream.read();
             if(!maybeType)
             {
-                return std::unexpected("no module type");
+                return stream.fail(ErrorCode::UNEXPECTED_END, "module type");
             }
             switch(*maybeType)
             {
@@ -109,8 +111,8 @@ namespace input
             case '&':
                 return ModuleType::CONJUNCTION;
             default:
-                return std::unexpected(
-                    std::format("invalid module type: {}", *maybeType));
+                return stream.fail(ErrorCode::UNEXPECTED_CHARACTER,
+                                   "module type");
             }
         }
 
@@ -120,14 +122,12 @@ namespace input
             const auto maybeType = parseModuleType(stream);
             if(!maybeType)
             {
-                return std::unexpected(std::format(
-                    "module type parsing failed: {}", maybeType.error()));
+                return std::unexpected(maybeType.error());
             }
             auto maybeName = parseName(stream);
             if(!maybeName)
             {
-                return std::unexpected(std::format(
-                    "module name parsing failed: {}", maybeName.error()));
+                return std::unexpected(maybeName.error());
             }
             return Module{
                 .name = std::move(*maybeName),
@@ -149,8 +149,7 @@ namespace input
             auto maybeModule = parseRegularModule(stream);
             if(!maybeModule)
             {
-                return std::unexpected(std::format("module parsing failed: {}",
-                                                   maybeModule.error()));
+                return std::unexpected(maybeModule.error());
             }
             return maybeModule;
         }
@@ -181,9 +180,7 @@ namespace input
                 auto maybeName = parseName(stream);
                 if(!maybeName)
                 {
-                    return std::unexpected(
-                        std::format("destination name parsing failed: {}",
-                                    maybeName.error()));
+                    return std::unexpected(maybeName.error());
                 }
                 names.push_back(std::move(*maybeName));
                 {
@@ -205,8 +202,7 @@ namespace input
             auto maybeModule = parseModule(stream);
             if(!maybeModule)
             {
-                return std::unexpected(std::format("module parsing failed: {}",
-                                                   maybeModule.error()));
+                return std::unexpected(maybeModule.error());
             }
             parseSpaces(stream);
             parseCharacter(stream, '-');
@@ -215,13 +211,12 @@ namespace input
             auto maybeDestinationNames = parseDestinationNames(stream);
             if(!maybeDestinationNames)
             {
-                return std::unexpected(
-                    std::format("destination names parsing failed: {}",
-                                maybeDestinationNames.error()));
+                return std::unexpected(maybeDestinationNames.error());
             }
             if(stream.peek().has_value())
             {
-                return std::unexpected("extra characters at the end");
+                return stream.fail(ErrorCode::TRAILING_CHARACTERS,
+                                   "connected module");
             }
             return ConnectedModule{.module = std::move(*maybeModule),
                                    .destinations =
@@ -250,7 +245,7 @@ namespace input
             {
                 return std::unexpected(
                     std::format("connected module parsing failed: {}",
-                                maybeModule.error()));
+                                maybeModule.error().message()));
             }
             configuration.modules.push_back(std::move(*maybeModule));
         }
@@ -271,275 +266,319 @@ namespace network
         return Signal{!std::to_underlying(signal)};
     }
 
-    namespace detail
-    {
-        class Module;
-        using ModuleID = const Module *;
+    using ModuleIdx = std::uint32_t;
 
-        class Module
-        {
-        public:
-            virtual ~Module() = default;
+    struct PulseCounts
+    {
+        ulval low{};
+        ulval high{};
+    };
 
-            virtual void registerSource(ModuleID sourceID) = 0;
-            virtual std::optional<Signal> process(Signal signal,
-                                                  ModuleID sourceID) = 0;
-            virtual std::optional<Signal> state() const = 0;
-        };
+    // Module ids [begin, end).
+    struct ModuleRange
+    {
+        ModuleIdx begin{};
+        ModuleIdx end{};
+    };
 
-        class BroadcasterModule : public Module
-        {
-        public:
-            void registerSource(ModuleID) override
-            {
-            }
-            std::optional<Signal> process(Signal signal, ModuleID) override
-            {
-                return signal;
-            }
-            std::optional<Signal> state() const override
-            {
-                return std::nullopt;
-            }
-        };
+    struct StateMask
+    {
+        ModuleRange range{};
+        std::size_t word{};
+        std::size_t shift{};
+        std::uint64_t mask{};
+    };
 
-        class FlipFlopModule : public Module
+    // The modules reachable from the root compiled into flat arrays: a type
+    // byte per module, the destinations in CSR form and, per edge, the
+    // input slot it feeds in a conjunction. Flip-flop states are a bitset
+    // indexed by module, conjunction inputs a bitset indexed by slot with
+    // a count of the high ones per conjunction.
+    class PulseEngine
+    {
+    public:
+        explicit PulseEngine(const input::Configuration &configuration,
+                             const input::Name &rootName)
         {
-        public:
-            void registerSource(ModuleID) override
+            std::unordered_map<std::string_view, const input::ConnectedModule *>
+                namedModules;
+            for(const auto &module : configuration.modules)
             {
+                namedModules.emplace(module.module.name, &module);
             }
-            std::optional<Signal> process(Signal signal, ModuleID) override
-            {
-                if(signal == Signal::LOW)
+            // breadth first from the root, discovering the reachable modules
+            std::vector<input::Name> found;
+            std::vector<input::ModuleType> foundTypes;
+            graphutil::Adjacency successors;
+            std::unordered_map<std::string_view, ModuleIdx> ids;
+            const auto moduleId = [&](const input::Name &name) {
+                const auto [iter, inserted] =
+                    ids.try_emplace(name, static_cast<ModuleIdx>(found.size()));
+                if(inserted)
                 {
-                    this->signal = flip(this->signal);
-                    return this->signal;
+                    found.push_back(name);
                 }
-                return std::nullopt;
-            }
-            std::optional<Signal> state() const override
+                return iter->second;
+            };
+            moduleId(rootName);
+            for(ModuleIdx idx = 0; idx < found.size(); ++idx)
             {
-                return signal;
+                successors.emplace_back();
+                const auto iter = namedModules.find(found[idx]);
+                if(iter == end(namedModules))
+                {
+                    foundTypes.push_back(input::ModuleType::UNKNOWN);
+                    continue;
+                }
+                foundTypes.push_back(iter->second->module.type);
+                for(const auto &dst : iter->second->destinations)
+                {
+                    const auto dstIdx = moduleId(dst);
+                    successors[idx].push_back(dstIdx);
+                }
             }
-
-        private:
-            Signal signal{Signal::LOW};
-        };
-
-        class ConjunctionModule : public Module
-        {
-        public:
-            void registerSource(ModuleID sourceID) override
+            // renumbered so that every strongly connected component is a
+            // contiguous range of module ids, and so of flip-flop bits
+            const auto components =
+                graphutil::stronglyConnectedComponents(successors);
+            std::vector<ModuleIdx> order(found.size());
+            std::iota(order.begin(), order.end(), ModuleIdx{0});
+            std::ranges::stable_sort(order, {}, [&](const ModuleIdx idx) {
+                return components.component[idx];
+            });
+            std::vector<ModuleIdx> newIds(found.size());
+            for(ModuleIdx idx = 0; idx < order.size(); ++idx)
             {
-                signals.emplace(sourceID, Signal::LOW);
+                newIds[order[idx]] = idx;
+                const auto component = components.component[order[idx]];
+                if(idx == 0 ||
+                   components.component[order[idx - 1]] != component)
+                {
+                    componentRanges.push_back({idx, idx});
+                }
+                ++componentRanges.back().end;
             }
-            std::optional<Signal> process(Signal signal,
-                                          ModuleID sourceID) override
+            root = newIds[0];
+            // one input slot per distinct source of a conjunction, the
+            // button counting as the source of the root
+            names.resize(found.size());
+            types.resize(found.size());
+            inputCounts.assign(found.size(), 0);
+            highCounts.assign(found.size(), 0);
+            std::unordered_map<std::uint64_t, ModuleIdx> slots;
+            const auto slotOf = [&](const ModuleIdx src, const ModuleIdx dst) {
+                if(types[dst] != input::ModuleType::CONJUNCTION)
+                {
+                    return NO_SLOT;
+                }
+                const auto key = (static_cast<std::uint64_t>(src) << 32) | dst;
+                const auto [iter, inserted] = slots.try_emplace(
+                    key, static_cast<ModuleIdx>(slots.size()));
+                inputCounts[dst] += inserted;
+                return iter->second;
+            };
+            for(ModuleIdx idx = 0; idx < found.size(); ++idx)
             {
-                signals[sourceID] = signal;
-                return std::ranges::all_of(
-                           signals | std::views::transform([](const auto &p) {
-                               return p.second;
-                           }),
-                           [](const auto s) { return s == Signal::HIGH; })
-                           ? Signal::LOW
-                           : Signal::HIGH;
+                names[newIds[idx]] = std::move(found[idx]);
+                types[newIds[idx]] = foundTypes[idx];
             }
-            std::optional<Signal> state() const override
+            rootSlot = slotOf(BUTTON, root);
+            childBegin.push_back(0);
+            for(const auto oldIdx : order)
             {
-                return std::nullopt;
+                for(const auto oldDst : successors[oldIdx])
+                {
+                    children.push_back(newIds[oldDst]);
+                    edgeSlots.push_back(
+                        slotOf(newIds[oldIdx], newIds[oldDst]));
+                }
+                childBegin.push_back(static_cast<ModuleIdx>(children.size()));
             }
-
-        private:
-            std::unordered_map<ModuleID, Signal> signals;
-        };
-    }
-
-    class Network
-    {
-    public:
-        struct NodeDescr
-        {
-            input::Name name{};
-            input::ModuleType type{};
-        };
-
-    private:
-        struct Node
-        {
-            NodeDescr descr;
-            std::unique_ptr<detail::Module> module;
-            std::vector<std::shared_ptr<Node>> children{};
-        };
-
-        using ModuleMap = std::unordered_map<
-            std::string_view,
-            std::reference_wrapper<const input::ConnectedModule>>;
-        using NodeMap = std::unordered_map<input::Name, std::shared_ptr<Node>>;
-
-    public:
-        explicit Network(const input::Configuration &configuration,
-                         const input::Name &rootName)
-        {
-            ModuleMap namedModules;
-            std::ranges::copy(configuration.modules |
-                                  std::views::transform([](const auto &module) {
-                                      return std::pair{
-                                          std::string_view(module.module.name),
-                                          std::cref(module)};
-                                  }),
-                              std::inserter(namedModules, end(namedModules)));
-            root = prepareNode(moduleNodes, rootName, namedModules);
+            flipFlops.assign(wordCount(names.size()), 0);
+            highInputs.assign(wordCount(slots.size()), 0);
+            queue.resize(std::bit_ceil(children.size() + 1));
         }
 
-        template<typename SignalHandler>
-        void exec(Signal signal, SignalHandler handler) const
+        // Presses the button once, counting the pulses sent including the
+        // button one. Allocates only when the pulse queue has to grow.
+        PulseCounts press()
         {
-            std::queue<
-                std::tuple<std::shared_ptr<Node>, Signal, detail::ModuleID>>
-                propagationQueue;
-            propagationQueue.push({
-                root,
-                signal,
-                nullptr,
-            });
-            while(!propagationQueue.empty())
+            std::array<ulval, 2> counts{};
+            head = tail = 0;
+            push({root, rootSlot, Signal::LOW});
+            while(head != tail)
             {
-                auto [node, signal, sourceID] = propagationQueue.front();
-                propagationQueue.pop();
-                assert(node);
-                if(!handler(node->descr, signal))
+                const auto pulse = queue[head++ & (queue.size() - 1)];
+                ++counts[std::to_underlying(pulse.signal)];
+                const auto target = pulse.target;
+                Signal out{};
+                switch(types[target])
                 {
+                case input::ModuleType::UNKNOWN:
                     continue;
-                }
-                if(node->module)
-                {
-                    const auto maybeNextSignal =
-                        node->module->process(signal, sourceID);
-                    if(maybeNextSignal)
+                case input::ModuleType::BROADCASTER:
+                    out = pulse.signal;
+                    break;
+                case input::ModuleType::FLIP_FLOP:
+                    if(pulse.signal == Signal::HIGH)
                     {
-                        for(const auto &child : node->children)
+                        continue;
+                    }
+                    out = Signal{toggle(flipFlops, target)};
+                    break;
+                case input::ModuleType::CONJUNCTION:
+                    if(test(highInputs, pulse.slot) !=
+                       (pulse.signal == Signal::HIGH))
+                    {
+                        if(toggle(highInputs, pulse.slot))
                         {
-                            propagationQueue.push(
-                                {child, *maybeNextSignal, node->module.get()});
+                            ++highCounts[target];
+                        }
+                        else
+                        {
+                            --highCounts[target];
                         }
                     }
+                    out = Signal{highCounts[target] != inputCounts[target]};
+                    break;
+                }
+                for(auto edge = childBegin[target];
+                    edge < childBegin[target + 1]; ++edge)
+                {
+                    push({children[edge], edgeSlots[edge], out});
                 }
             }
+            return {counts[0], counts[1]};
+        }
+
+        [[nodiscard]] std::size_t size() const
+        {
+            return names.size();
+        }
+        [[nodiscard]] const input::Name &name(const ModuleIdx idx) const
+        {
+            return names[idx];
+        }
+        [[nodiscard]] bool flipFlopState(const ModuleIdx idx) const
+        {
+            return test(flipFlops, idx);
+        }
+
+        // Flip-flop states indexed by module.
+        [[nodiscard]] std::span<const std::uint64_t> snapshot() const
+        {
+            return flipFlops;
         }
 
-        template<typename NodeHandler>
-        void traverse(
-            NodeHandler handler,
-            const std::optional<input::Name> &startModuleName = {}) const
+        // The strongly connected components holding flip-flops, each with
+        // the mask extracting its state, std::unexpected when one is wider
+        // than a state word.
+        [[nodiscard]] std::expected<std::vector<StateMask>, std::string>
+        counterMasks() const
         {
-            auto cur = root;
-            if(startModuleName)
+            std::vector<StateMask> result;
+            for(const auto &range : componentRanges)
             {
-                if(const auto iter = moduleNodes.find(*startModuleName);
-                   iter != end(moduleNodes))
+                if(std::ranges::none_of(
+                       std::views::iota(range.begin, range.end),
+                       [&](const ModuleIdx idx) {
+                           return types[idx] == input::ModuleType::FLIP_FLOP;
+                       }))
                 {
-                    cur = iter->second;
+                    continue;
                 }
-                else
+                const auto width = range.end - range.begin;
+                if(width > WORD_BITS)
                 {
-                    return;
+                    return std::unexpected(std::format(
+                        "component of {} is too wide: {} modules",
+                        names[range.begin], width));
                 }
+                result.push_back({
+                    .range = range,
+                    .word = range.begin / WORD_BITS,
+                    .shift = range.begin % WORD_BITS,
+                    .mask = (width == WORD_BITS
+                                 ? ~std::uint64_t{0}
+                                 : (std::uint64_t{1} << width) - 1),
+                });
             }
-            traverse(cur, handler);
+            return result;
         }
 
-        std::optional<Signal> state(const input::Name &moduleName) const
+        // Flip-flop states of a component as the low bits of a word.
+        [[nodiscard]] std::uint64_t state(const StateMask &mask) const
         {
-            const auto iter = moduleNodes.find(moduleName);
-            if(iter == end(moduleNodes) || !iter->second->module)
+            auto bits = flipFlops[mask.word] >> mask.shift;
+            if(mask.shift != 0 && mask.word + 1 < flipFlops.size())
             {
-                return std::nullopt;
+                bits |= flipFlops[mask.word + 1] << (WORD_BITS - mask.shift);
             }
-            return iter->second->module->state();
+            return bits & mask.mask;
         }
 
     private:
-        static std::shared_ptr<Node> prepareNode(NodeMap &nodes,
-                                                 const input::Name &name,
-                                                 const ModuleMap &namedModules)
+        static constexpr ModuleIdx NO_SLOT =
+            std::numeric_limits<ModuleIdx>::max();
+        static constexpr ModuleIdx BUTTON = NO_SLOT;
+        static constexpr std::size_t WORD_BITS = 64;
+
+        struct Pulse
         {
-            if(const auto iter = nodes.find(name); iter != end(nodes))
-            {
-                return iter->second;
-            }
-            const auto moduleIter = namedModules.find(name);
-            auto resultModule = [&]() -> std::unique_ptr<detail::Module> {
-                if(moduleIter == end(namedModules))
-                {
-                    return {};
-                }
-                const auto &module = moduleIter->second.get();
-                switch(module.module.type)
-                {
-                case input::ModuleType::UNKNOWN:
-                    return {};
-                case input::ModuleType::BROADCASTER:
-                    return std::make_unique<detail::BroadcasterModule>();
-                case input::ModuleType::FLIP_FLOP:
-                    return std::make_unique<detail::FlipFlopModule>();
-                case input::ModuleType::CONJUNCTION:
-                    return std::make_unique<detail::ConjunctionModule>();
-                }
-                std::unreachable();
-            }();
-            auto node = std::make_shared<Node>(
-                NodeDescr{
-                    .name = name,
-                },
-                std::move(resultModule));
-            nodes.emplace(name, node);
-            if(moduleIter != end(namedModules))
-            {
-                node->descr.type = moduleIter->second.get().module.type;
-                for(const auto &dst : moduleIter->second.get().destinations)
-                {
-                    auto &child = node->children.emplace_back(
-                        prepareNode(nodes, dst, namedModules));
-                    assert(child);
-                    if(child->module)
-                    {
-                        child->module->registerSource(node->module.get());
-                    }
-                }
-            }
-            return node;
+            ModuleIdx target{};
+            ModuleIdx slot{};
+            Signal signal{};
+        };
+
+        static std::size_t wordCount(const std::size_t bits)
+        {
+            return (bits + WORD_BITS - 1) / WORD_BITS;
+        }
+        static bool test(const std::vector<std::uint64_t> &bits,
+                         const std::size_t idx)
+        {
+            return (bits[idx / WORD_BITS] >> (idx % WORD_BITS)) & 1;
+        }
+        // Flips the bit, returning its new value.
+        static bool toggle(std::vector<std::uint64_t> &bits,
+                           const std::size_t idx)
+        {
+            auto &word = bits[idx / WORD_BITS];
+            word ^= std::uint64_t{1} << (idx % WORD_BITS);
+            return (word >> (idx % WORD_BITS)) & 1;
         }
 
-        template<typename NodeHandler>
-        static void traverse(const std::shared_ptr<Node> root,
-                             NodeHandler handler)
+        void push(const Pulse &pulse)
         {
-            std::queue<std::shared_ptr<Node>> front;
-            std::unordered_set<const Node *> seen{root.get()};
-            front.push(root);
-            while(!front.empty())
+            if(tail - head == queue.size())
             {
-                auto cur = front.front();
-                front.pop();
-                assert(cur);
-                std::vector<NodeDescr> childrenDescrs;
-                for(const auto &child : cur->children)
+                std::vector<Pulse> grown(queue.size() * 2);
+                for(std::size_t idx = 0; idx < queue.size(); ++idx)
                 {
-                    childrenDescrs.push_back(child->descr);
-                    if(seen.insert(child.get()).second)
-                    {
-                        front.push(child);
-                    }
+                    grown[idx] = queue[(head + idx) & (queue.size() - 1)];
                 }
-                handler(cur->descr, childrenDescrs,
-                        cur->module ? cur->module->state() : std::nullopt);
+                tail -= head;
+                head = 0;
+                queue = std::move(grown);
             }
+            queue[tail++ & (queue.size() - 1)] = pulse;
         }
 
-        NodeMap moduleNodes;
-        std::shared_ptr<Node> root{};
+        std::vector<input::Name> names;
+        std::vector<input::ModuleType> types;
+        std::vector<ModuleIdx> childBegin;
+        std::vector<ModuleIdx> children;
+        std::vector<ModuleIdx> edgeSlots;
+        std::vector<ModuleIdx> inputCounts;
+        std::vector<ModuleIdx> highCounts;
+        ModuleIdx root{};
+        ModuleIdx rootSlot{};
+        std::vector<ModuleRange> componentRanges;
+        std::vector<std::uint64_t> flipFlops;
+        std::vector<std::uint64_t> highInputs;
+        std::vector<Pulse> queue;
+        std::size_t head{};
+        std::size_t tail{};
     };
 }
 }
@@ -0,0 +1,226 @@
+#ifndef XUTIL_CYCLE_HPP
+#define XUTIL_CYCLE_HPP
+
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <ranges>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// 2020/22 includes this header as well and is compiled as C++20, keep it
+// within that standard.
+namespace xutil
+{
+using Fingerprint = std::uint64_t;
+
+struct Cycle
+{
+    std::size_t start{};
+    std::size_t length{};
+
+    friend auto operator<=>(const Cycle &, const Cycle &) = default;
+};
+
+// Index of the state after `steps` steps mapped into the first loop period.
+constexpr std::size_t cycleIndex(const Cycle &cycle, const std::size_t steps)
+{
+    if(steps < cycle.start || cycle.length == 0)
+    {
+        return steps;
+    }
+    return cycle.start + (steps - cycle.start) % cycle.length;
+}
+
+namespace detail
+{
+    // splitmix64 finalizer
+    constexpr Fingerprint mix(Fingerprint val)
+    {
+        val += 0x9e3779b97f4a7c15ULL;
+        val = (val ^ (val >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        val = (val ^ (val >> 27)) * 0x94d049bb133111ebULL;
+        return val ^ (val >> 31);
+    }
+
+    constexpr Fingerprint inverse(const Fingerprint val)
+    {
+        Fingerprint result = val;
+        for(int i = 0; i < 5; ++i)
+        {
+            result *= 2 - val * result;
+        }
+        return result;
+    }
+}
+
+constexpr Fingerprint hashCombine(const Fingerprint seed,
+                                  const Fingerprint val)
+{
+    return detail::mix(seed ^ (detail::mix(val) + (seed << 6) + (seed >> 2)));
+}
+
+template<std::ranges::input_range R>
+requires std::convertible_to<std::ranges::range_value_t<R>, Fingerprint>
+constexpr Fingerprint fingerprint(const R &values, Fingerprint seed = 0)
+{
+    for(const auto &val : values)
+    {
+        seed = hashCombine(seed, static_cast<Fingerprint>(val));
+    }
+    return seed;
+}
+
+// Brent's algorithm, constant memory. `step` returns either the next state or
+// an optional one, where std::nullopt terminates the sequence without a loop.
+template<std::copyable State, typename Step, typename Eq = std::equal_to<>>
+requires std::is_invocable_v<Step, const State &>
+std::optional<Cycle> findCycle(const State &init, Step step, Eq eq = {})
+{
+    const auto advance = [&](const State &state) -> std::optional<State> {
+        return std::invoke(step, state);
+    };
+    std::size_t power = 1;
+    std::size_t length = 1;
+    State tortoise = init;
+    auto hare = advance(init);
+    while(hare && !std::invoke(eq, tortoise, *hare))
+    {
+        if(power == length)
+        {
+            tortoise = *hare;
+            power *= 2;
+            length = 0;
+        }
+        hare = advance(*hare);
+        ++length;
+    }
+    if(!hare)
+    {
+        return std::nullopt;
+    }
+    std::optional<State> head = init;
+    std::optional<State> ahead = init;
+    for(std::size_t i = 0; i < length; ++i)
+    {
+        ahead = advance(*ahead);
+    }
+    std::size_t start = 0;
+    while(!std::invoke(eq, *head, *ahead))
+    {
+        head = advance(*head);
+        ahead = advance(*ahead);
+        ++start;
+    }
+    return Cycle{start, length};
+}
+
+// Keeps only the fingerprints of the observed states, the first repeated one
+// closes the loop.
+class CycleDetector
+{
+public:
+    std::optional<Cycle> observe(const Fingerprint state)
+    {
+        const auto [iter, inserted] = seen.emplace(state, observed);
+        ++observed;
+        if(inserted)
+        {
+            return std::nullopt;
+        }
+        return Cycle{iter->second, observed - 1 - iter->second};
+    }
+
+    [[nodiscard]] std::size_t size() const
+    {
+        return observed;
+    }
+
+    void reset()
+    {
+        seen.clear();
+        observed = 0;
+    }
+
+private:
+    std::unordered_map<Fingerprint, std::size_t> seen;
+    std::size_t observed{};
+};
+
+// Zobrist keys: a state hash is the xor of the keys of its present features,
+// so adding or removing one feature is a single xor.
+class ZobristTable
+{
+public:
+    explicit ZobristTable(std::size_t features, Fingerprint seed = 0)
+        : keys(features)
+    {
+        for(auto &key : keys)
+        {
+            key = detail::mix(seed++);
+        }
+    }
+
+    [[nodiscard]] Fingerprint operator[](const std::size_t feature) const
+    {
+        return keys[feature];
+    }
+
+    [[nodiscard]] Fingerprint toggle(const Fingerprint state,
+                                     const std::size_t feature) const
+    {
+        return state ^ keys[feature];
+    }
+
+    [[nodiscard]] Fingerprint move(const Fingerprint state,
+                                   const std::size_t from,
+                                   const std::size_t to) const
+    {
+        return state ^ keys[from] ^ keys[to];
+    }
+
+    [[nodiscard]] std::size_t size() const
+    {
+        return keys.size();
+    }
+
+private:
+    std::vector<Fingerprint> keys;
+};
+
+// Polynomial hash of a FIFO sequence updated in O(1) on both ends.
+class QueueHash
+{
+public:
+    void push(const Fingerprint val)
+    {
+        state = state * BASE + detail::mix(val);
+        power *= BASE;
+    }
+
+    void pop(const Fingerprint val)
+    {
+        power *= BASE_INVERSE;
+        state -= detail::mix(val) * power;
+    }
+
+    [[nodiscard]] Fingerprint value() const
+    {
+        return state;
+    }
+
+private:
+    static constexpr Fingerprint BASE = 0x100000001b3ULL;
+    static constexpr Fingerprint BASE_INVERSE = detail::inverse(BASE);
+    static_assert(BASE * BASE_INVERSE == 1);
+
+    Fingerprint state{};
+    Fingerprint power{1};
+};
+}
+
+#endif
@@ -0,0 +1,90 @@
+#ifndef GRAPHSCC_HPP
+#define GRAPHSCC_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace graphutil
+{
+using NodeIdx = std::uint32_t;
+using Adjacency = std::vector<std::vector<NodeIdx>>;
+
+struct Components
+{
+    // Component of every node, successors of a component come before it.
+    std::vector<NodeIdx> component;
+    NodeIdx count{};
+};
+
+// Tarjan's algorithm with an explicit stack, so that long chains can't
+// overflow the call stack.
+inline Components stronglyConnectedComponents(const Adjacency &successors)
+{
+    constexpr auto UNSET = std::numeric_limits<NodeIdx>::max();
+    const auto size = successors.size();
+    Components result{std::vector<NodeIdx>(size, UNSET), 0};
+    std::vector<NodeIdx> index(size, UNSET);
+    std::vector<NodeIdx> low(size);
+    std::vector<bool> onStack(size);
+    std::vector<NodeIdx> stack;
+    std::vector<std::pair<NodeIdx, std::size_t>> frames;
+    NodeIdx counter = 0;
+    const auto open = [&](const NodeIdx node) {
+        index[node] = low[node] = counter++;
+        stack.push_back(node);
+        onStack[node] = true;
+        frames.emplace_back(node, 0);
+    };
+    for(NodeIdx root = 0; root < size; ++root)
+    {
+        if(index[root] != UNSET)
+        {
+            continue;
+        }
+        open(root);
+        while(!frames.empty())
+        {
+            const auto node = frames.back().first;
+            const auto &next = successors[node];
+            if(auto &edge = frames.back().second; edge < next.size())
+            {
+                const auto succ = next[edge++];
+                if(index[succ] == UNSET)
+                {
+                    open(succ);
+                }
+                else if(onStack[succ])
+                {
+                    low[node] = std::min(low[node], index[succ]);
+                }
+                continue;
+            }
+            if(low[node] == index[node])
+            {
+                NodeIdx member = UNSET;
+                do
+                {
+                    member = stack.back();
+                    stack.pop_back();
+                    onStack[member] = false;
+                    result.component[member] = result.count;
+                } while(member != node);
+                ++result.count;
+            }
+            frames.pop_back();
+            if(!frames.empty())
+            {
+                auto &parentLow = low[frames.back().first];
+                parentLow = std::min(parentLow, low[node]);
+            }
+        }
+    }
+    return result;
+}
+}
+
+#endif
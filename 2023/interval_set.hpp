@@ -0,0 +1,575 @@
+#ifndef XUTIL_INTERVALSET_HPP
+#define XUTIL_INTERVALSET_HPP
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <limits>
+#include <numeric>
+#include <optional>
+#include <ranges>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Shared with the 2020 solutions (2020/16), which build as C++20, so this
+// header sticks to the C++20 library.
+namespace xutil
+{
+template<std::integral T>
+struct Interval
+{
+    T begin{};
+    T end{};
+
+    [[nodiscard]] constexpr bool empty() const
+    {
+        return begin >= end;
+    }
+    [[nodiscard]] constexpr T length() const
+    {
+        return empty() ? T{} : end - begin;
+    }
+    [[nodiscard]] constexpr bool contains(const T val) const
+    {
+        return val >= begin && val < end;
+    }
+
+    friend auto operator<=>(const Interval &, const Interval &) = default;
+};
+
+template<std::integral T>
+constexpr Interval<T> intersect(const Interval<T> &left,
+                                const Interval<T> &right)
+{
+    return Interval<T>{std::max(left.begin, right.begin),
+                       std::min(left.end, right.end)};
+}
+
+// Disjoint, non-adjacent intervals sorted by their begin.
+template<std::integral T>
+class IntervalSet
+{
+public:
+    using value_type = Interval<T>;
+
+    IntervalSet() = default;
+    IntervalSet(std::initializer_list<Interval<T>> intervals)
+        : IntervalSet(std::vector<Interval<T>>(intervals))
+    {
+    }
+    template<std::ranges::input_range R>
+    requires(!std::same_as<std::remove_cvref_t<R>, IntervalSet> &&
+             std::convertible_to<std::ranges::range_value_t<R>, Interval<T>>)
+    explicit IntervalSet(R &&intervals)
+    {
+        std::vector<Interval<T>> sorted;
+        for(const auto &interval : intervals)
+        {
+            if(!Interval<T>(interval).empty())
+            {
+                sorted.push_back(interval);
+            }
+        }
+        std::ranges::sort(sorted);
+        for(const auto &interval : sorted)
+        {
+            append(interval);
+        }
+    }
+
+    [[nodiscard]] bool contains(const T val) const
+    {
+        const auto iter = std::ranges::upper_bound(intervals, val, {},
+                                                   &Interval<T>::begin);
+        return iter != intervals.begin() && std::prev(iter)->contains(val);
+    }
+
+    // Membership of every query in one merge pass, `queries` must be sorted.
+    template<std::ranges::input_range R, std::output_iterator<bool> Out>
+    Out containsSorted(R &&queries, Out out) const
+    {
+        auto iter = intervals.begin();
+        for(const T val : queries)
+        {
+            while(iter != intervals.end() && iter->end <= val)
+            {
+                ++iter;
+            }
+            *out++ = (iter != intervals.end() && iter->contains(val));
+        }
+        return out;
+    }
+
+    void insert(const Interval<T> &interval)
+    {
+        *this = unite(*this, IntervalSet({interval}));
+    }
+
+    [[nodiscard]] T measure() const
+    {
+        T result{};
+        for(const auto &interval : intervals)
+        {
+            result += interval.length();
+        }
+        return result;
+    }
+
+    [[nodiscard]] bool empty() const
+    {
+        return intervals.empty();
+    }
+    [[nodiscard]] std::size_t size() const
+    {
+        return intervals.size();
+    }
+    [[nodiscard]] auto begin() const
+    {
+        return intervals.begin();
+    }
+    [[nodiscard]] auto end() const
+    {
+        return intervals.end();
+    }
+    [[nodiscard]] const Interval<T> &front() const
+    {
+        return intervals.front();
+    }
+    [[nodiscard]] const Interval<T> &back() const
+    {
+        return intervals.back();
+    }
+
+    friend IntervalSet unite(const IntervalSet &left, const IntervalSet &right)
+    {
+        IntervalSet result;
+        result.intervals.reserve(left.size() + right.size());
+        auto leftIter = left.intervals.begin();
+        auto rightIter = right.intervals.begin();
+        while(leftIter != left.intervals.end() ||
+              rightIter != right.intervals.end())
+        {
+            if(rightIter == right.intervals.end() ||
+               (leftIter != left.intervals.end() &&
+                leftIter->begin < rightIter->begin))
+            {
+                result.append(*leftIter++);
+            }
+            else
+            {
+                result.append(*rightIter++);
+            }
+        }
+        return result;
+    }
+
+    friend IntervalSet intersect(const IntervalSet &left,
+                                 const IntervalSet &right)
+    {
+        IntervalSet result;
+        auto leftIter = left.intervals.begin();
+        auto rightIter = right.intervals.begin();
+        while(leftIter != left.intervals.end() &&
+              rightIter != right.intervals.end())
+        {
+            if(const auto common = xutil::intersect(*leftIter, *rightIter);
+               !common.empty())
+            {
+                result.intervals.push_back(common);
+            }
+            if(leftIter->end < rightIter->end)
+            {
+                ++leftIter;
+            }
+            else
+            {
+                ++rightIter;
+            }
+        }
+        return result;
+    }
+
+    friend IntervalSet subtract(const IntervalSet &left,
+                                const IntervalSet &right)
+    {
+        IntervalSet result;
+        auto rightIter = right.intervals.begin();
+        for(auto cur : left.intervals)
+        {
+            while(rightIter != right.intervals.end() &&
+                  rightIter->end <= cur.begin)
+            {
+                ++rightIter;
+            }
+            for(auto iter = rightIter;
+                iter != right.intervals.end() && iter->begin < cur.end; ++iter)
+            {
+                if(cur.begin < iter->begin)
+                {
+                    result.intervals.push_back({cur.begin, iter->begin});
+                }
+                cur.begin = std::max(cur.begin, iter->end);
+            }
+            if(!cur.empty())
+            {
+                result.intervals.push_back(cur);
+            }
+        }
+        return result;
+    }
+
+    friend IntervalSet operator|(const IntervalSet &left,
+                                 const IntervalSet &right)
+    {
+        return unite(left, right);
+    }
+    friend IntervalSet operator&(const IntervalSet &left,
+                                 const IntervalSet &right)
+    {
+        return intersect(left, right);
+    }
+    friend IntervalSet operator-(const IntervalSet &left,
+                                 const IntervalSet &right)
+    {
+        return subtract(left, right);
+    }
+
+    friend bool operator==(const IntervalSet &, const IntervalSet &) = default;
+
+private:
+    void append(const Interval<T> &interval)
+    {
+        if(!intervals.empty() && intervals.back().end >= interval.begin)
+        {
+            intervals.back().end = std::max(intervals.back().end, interval.end);
+        }
+        else
+        {
+            intervals.push_back(interval);
+        }
+    }
+
+    std::vector<Interval<T>> intervals;
+};
+
+// Piecewise-linear map: each piece shifts its source interval to start at
+// `destination`, values outside of all pieces map to themselves.
+template<std::integral T>
+class IntervalMap
+{
+public:
+    struct Piece
+    {
+        Interval<T> source{};
+        T destination{};
+
+        [[nodiscard]] constexpr T operator()(const T val) const
+        {
+            return destination + (val - source.begin);
+        }
+
+        friend auto operator<=>(const Piece &, const Piece &) = default;
+    };
+
+    IntervalMap() = default;
+    template<std::ranges::input_range R>
+    requires std::convertible_to<std::ranges::range_value_t<R>, Piece>
+    explicit IntervalMap(R &&values)
+    {
+        std::vector<Piece> sorted(std::ranges::begin(values),
+                                  std::ranges::end(values));
+        std::ranges::sort(sorted);
+        for(const auto &piece : sorted)
+        {
+            assert(pieces.empty() ||
+                   pieces.back().source.end <= piece.source.begin);
+            append(piece);
+        }
+    }
+
+    [[nodiscard]] T operator()(const T val) const
+    {
+        const auto iter = std::ranges::upper_bound(
+            pieces, val, {}, [](const auto &piece) {
+                return piece.source.begin;
+            });
+        if(iter != begin(pieces) && std::prev(iter)->source.contains(val))
+        {
+            return (*std::prev(iter))(val);
+        }
+        return val;
+    }
+
+    // Maps every query in one merge pass, `queries` must be sorted.
+    template<std::ranges::input_range R, std::output_iterator<T> Out>
+    Out lookupSorted(R &&queries, Out out) const
+    {
+        auto iter = begin(pieces);
+        for(const T val : queries)
+        {
+            while(iter != end(pieces) && iter->source.end <= val)
+            {
+                ++iter;
+            }
+            *out++ = (iter != end(pieces) && iter->source.contains(val))
+                         ? (*iter)(val)
+                         : val;
+        }
+        return out;
+    }
+
+    // Calls `func(source, destination)` for the consecutive linear segments
+    // covering `interval`, identity gaps included.
+    template<typename Func>
+    void forEachSegment(const Interval<T> &interval, Func &&func) const
+    {
+        auto cur = interval.begin;
+        auto iter = std::ranges::upper_bound(
+            pieces, cur, {}, [](const auto &piece) {
+                return piece.source.begin;
+            });
+        if(iter != begin(pieces) && std::prev(iter)->source.end > cur)
+        {
+            --iter;
+        }
+        while(cur < interval.end)
+        {
+            if(iter != end(pieces) && iter->source.begin <= cur)
+            {
+                const auto stop = std::min(interval.end, iter->source.end);
+                func(Interval<T>{cur, stop}, (*iter)(cur));
+                cur = stop;
+                ++iter;
+            }
+            else
+            {
+                const auto stop = (iter != end(pieces)
+                                       ? std::min(interval.end,
+                                                  iter->source.begin)
+                                       : interval.end);
+                func(Interval<T>{cur, stop}, cur);
+                cur = stop;
+            }
+        }
+    }
+
+    [[nodiscard]] IntervalSet<T> image(const IntervalSet<T> &values) const
+    {
+        std::vector<Interval<T>> result;
+        for(const auto &interval : values)
+        {
+            forEachSegment(interval, [&](const auto &source, const T dst) {
+                result.push_back({dst, dst + source.length()});
+            });
+        }
+        return IntervalSet<T>(result);
+    }
+
+    // The map applying `this` first and `next` to its result.
+    [[nodiscard]] IntervalMap then(const IntervalMap &next) const
+    {
+        IntervalMap result;
+        const auto through = [&](const Interval<T> &source, const T dst) {
+            next.forEachSegment(
+                Interval<T>{dst, dst + source.length()},
+                [&](const auto &nextSource, const T nextDst) {
+                    const auto offset = nextSource.begin - dst;
+                    result.append(Piece{
+                        {source.begin + offset,
+                         source.begin + offset + nextSource.length()},
+                        nextDst,
+                    });
+                });
+        };
+        forEachSegment(Interval<T>{std::numeric_limits<T>::min(),
+                                   std::numeric_limits<T>::max()},
+                       through);
+        return result;
+    }
+
+    [[nodiscard]] const std::vector<Piece> &segments() const
+    {
+        return pieces;
+    }
+
+    friend bool operator==(const IntervalMap &, const IntervalMap &) = default;
+
+private:
+    void append(const Piece &piece)
+    {
+        if(piece.source.empty() || piece.destination == piece.source.begin)
+        {
+            return;
+        }
+        if(!pieces.empty() && pieces.back().source.end == piece.source.begin &&
+           pieces.back()(piece.source.begin) == piece.destination)
+        {
+            pieces.back().source.end = piece.source.end;
+            return;
+        }
+        pieces.push_back(piece);
+    }
+
+    std::vector<Piece> pieces;
+};
+
+// Flat lookup table of an IntervalMap: the breakpoints where the offset
+// changes sorted in one array, and additionally in Eytzinger order for a
+// branchless single value search.
+template<std::integral T>
+class OffsetTable
+{
+public:
+    explicit OffsetTable(const IntervalMap<T> &map)
+    {
+        for(const auto &piece : map.segments())
+        {
+            if(keys.empty() || keys.back() != piece.source.begin)
+            {
+                keys.push_back(piece.source.begin);
+                offsets.push_back(offsetOf(piece));
+            }
+            else
+            {
+                offsets.back() = offsetOf(piece);
+            }
+            keys.push_back(piece.source.end);
+            offsets.push_back(0);
+        }
+        tree.resize(keys.size() + 1);
+        treeOffsets.resize(keys.size() + 1);
+        std::size_t idx = 0;
+        fillTree(1, idx);
+    }
+
+    [[nodiscard]] T operator()(const T val) const
+    {
+        const auto size = keys.size();
+        std::size_t k = 1;
+        while(k <= size)
+        {
+            k = 2 * k + static_cast<std::size_t>(tree[k] <= val);
+        }
+        // k is now the node of the first key greater than val, or 0
+        k >>= std::countr_one(k) + 1;
+        return apply(val, k == 0 ? lastOffset() : treeOffsets[k]);
+    }
+
+    // Maps every query in one merge pass, `queries` must be sorted.
+    template<std::ranges::input_range R, std::output_iterator<T> Out>
+    Out lookupSorted(R &&queries, Out out) const
+    {
+        std::size_t idx = 0;
+        for(const T val : queries)
+        {
+            while(idx < keys.size() && keys[idx] <= val)
+            {
+                ++idx;
+            }
+            *out++ = apply(val, idx == 0 ? U{} : offsets[idx - 1]);
+        }
+        return out;
+    }
+
+    // Answers the queries in sorted order with lookupSorted, the results
+    // keep the order of `values`.
+    [[nodiscard]] std::vector<T> lookupBatch(
+        const std::span<const T> values) const
+    {
+        std::vector<std::size_t> order(values.size());
+        std::iota(order.begin(), order.end(), std::size_t{});
+        const auto valueOf = [&](const std::size_t idx) {
+            return values[idx];
+        };
+        std::ranges::sort(order, {}, valueOf);
+        std::vector<T> sorted;
+        sorted.reserve(values.size());
+        lookupSorted(order | std::views::transform(valueOf),
+                     std::back_inserter(sorted));
+        std::vector<T> results(values.size());
+        for(std::size_t idx = 0; idx < order.size(); ++idx)
+        {
+            results[order[idx]] = sorted[idx];
+        }
+        return results;
+    }
+
+    // The map is increasing between breakpoints, so the minimum over an
+    // interval is at its begin or at one of the breakpoints inside it.
+    [[nodiscard]] std::optional<T> minimum(const Interval<T> &interval) const
+    {
+        if(interval.empty())
+        {
+            return std::nullopt;
+        }
+        auto result = (*this)(interval.begin);
+        for(auto idx = static_cast<std::size_t>(
+                std::ranges::upper_bound(keys, interval.begin) - keys.begin());
+            idx < keys.size() && keys[idx] < interval.end; ++idx)
+        {
+            result = std::min(result, apply(keys[idx], offsets[idx]));
+        }
+        return result;
+    }
+
+    [[nodiscard]] std::optional<T> minimum(const IntervalSet<T> &values) const
+    {
+        std::optional<T> result;
+        for(const auto &interval : values)
+        {
+            if(const auto cur = minimum(interval); !result || *cur < *result)
+            {
+                result = cur;
+            }
+        }
+        return result;
+    }
+
+private:
+    using U = std::make_unsigned_t<T>;
+
+    static U offsetOf(const typename IntervalMap<T>::Piece &piece)
+    {
+        return static_cast<U>(piece.destination) -
+               static_cast<U>(piece.source.begin);
+    }
+
+    static T apply(const T val, const U offset)
+    {
+        return static_cast<T>(static_cast<U>(val) + offset);
+    }
+
+    [[nodiscard]] U lastOffset() const
+    {
+        return offsets.empty() ? U{} : offsets.back();
+    }
+
+    // In-order traversal of the implicit tree assigns the sorted keys, every
+    // node also keeps the offset applying right below its key.
+    void fillTree(const std::size_t k, std::size_t &idx)
+    {
+        if(k > keys.size())
+        {
+            return;
+        }
+        fillTree(2 * k, idx);
+        tree[k] = keys[idx];
+        treeOffsets[k] = (idx == 0 ? U{} : offsets[idx - 1]);
+        ++idx;
+        fillTree(2 * k + 1, idx);
+    }
+
+    std::vector<T> keys;
+    std::vector<U> offsets;
+    std::vector<T> tree;
+    std::vector<U> treeOffsets;
+};
+}
+
+#endif
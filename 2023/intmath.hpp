@@ -0,0 +1,241 @@
+#ifndef NUMUTIL_INTMATH_HPP
+#define NUMUTIL_INTMATH_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <concepts>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <optional>
+#include <ranges>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+// Also used from 2020 (days 13 and 25), whose sources are C++20: nothing
+// newer than the C++20 standard library belongs here.
+namespace numutil
+{
+using umax = std::uint64_t;
+using smax = std::int64_t;
+
+struct GcdResult
+{
+    smax gcd{};
+    smax x{};
+    smax y{};
+};
+
+// Congruence value = residue (mod modulus).
+struct Congruence
+{
+    umax residue{};
+    umax modulus{1};
+
+    friend auto operator<=>(const Congruence &, const Congruence &) = default;
+};
+
+constexpr umax mulmod(const umax left, const umax right, const umax mod)
+{
+    return static_cast<umax>(static_cast<unsigned __int128>(left) * right %
+                             mod);
+}
+
+constexpr umax powmod(umax base, umax exp, const umax mod)
+{
+    umax result = 1 % mod;
+    base %= mod;
+    while(exp > 0)
+    {
+        if(exp & 1)
+        {
+            result = mulmod(result, base, mod);
+        }
+        base = mulmod(base, base, mod);
+        exp >>= 1;
+    }
+    return result;
+}
+
+// gcd == left * x + right * y
+constexpr GcdResult extendedGcd(const smax left, const smax right)
+{
+    smax oldR = left;
+    smax r = right;
+    smax oldX = 1;
+    smax x = 0;
+    smax oldY = 0;
+    smax y = 1;
+    while(r != 0)
+    {
+        const auto q = oldR / r;
+        oldR = std::exchange(r, oldR - q * r);
+        oldX = std::exchange(x, oldX - q * x);
+        oldY = std::exchange(y, oldY - q * y);
+    }
+    if(oldR < 0)
+    {
+        return {-oldR, -oldX, -oldY};
+    }
+    return {oldR, oldX, oldY};
+}
+
+constexpr std::optional<umax> modInverse(const umax value, const umax mod)
+{
+    if(mod == 0 || mod > static_cast<umax>(std::numeric_limits<smax>::max()))
+    {
+        return std::nullopt;
+    }
+    const auto [g, x, y] =
+        extendedGcd(static_cast<smax>(value % mod), static_cast<smax>(mod));
+    if(g != 1)
+    {
+        return std::nullopt;
+    }
+    const auto smod = static_cast<smax>(mod);
+    return static_cast<umax>((x % smod + smod) % smod);
+}
+
+template<std::unsigned_integral T>
+constexpr std::optional<T> checkedMul(const T left, const T right)
+{
+    if(left != 0 && right > std::numeric_limits<T>::max() / left)
+    {
+        return std::nullopt;
+    }
+    return left * right;
+}
+
+template<std::unsigned_integral T>
+constexpr std::optional<T> checkedLcm(const T left, const T right)
+{
+    if(left == 0 || right == 0)
+    {
+        return T{};
+    }
+    return checkedMul(static_cast<T>(left / std::gcd(left, right)), right);
+}
+
+template<std::ranges::input_range R>
+requires std::unsigned_integral<std::ranges::range_value_t<R>>
+constexpr std::optional<std::ranges::range_value_t<R>> checkedLcm(R &&values)
+{
+    using T = std::ranges::range_value_t<R>;
+    std::optional<T> result = 1;
+    for(const T val : values)
+    {
+        result = checkedLcm(*result, val);
+        if(!result)
+        {
+            break;
+        }
+    }
+    return result;
+}
+
+// Merges two congruences with arbitrary, not necessarily coprime moduli.
+constexpr std::optional<Congruence> crt(const Congruence &left,
+                                        const Congruence &right)
+{
+    const auto g = std::gcd(left.modulus, right.modulus);
+    const auto leftResidue = left.residue % left.modulus;
+    const auto rightResidue = right.residue % right.modulus;
+    const auto diff =
+        (rightResidue + right.modulus - leftResidue % right.modulus) %
+        right.modulus;
+    if(diff % g != 0)
+    {
+        return std::nullopt;
+    }
+    const auto maybeModulus = checkedLcm(left.modulus, right.modulus);
+    if(!maybeModulus)
+    {
+        return std::nullopt;
+    }
+    const auto reducedModulus = right.modulus / g;
+    const auto maybeInverse =
+        modInverse((left.modulus / g) % reducedModulus, reducedModulus);
+    if(!maybeInverse)
+    {
+        return std::nullopt;
+    }
+    // left.residue + left.modulus * k, k = diff / g * inverse (mod reduced)
+    const auto k = mulmod(diff / g, *maybeInverse, reducedModulus);
+    const auto step = static_cast<unsigned __int128>(left.modulus) * k;
+    return Congruence{
+        static_cast<umax>((leftResidue + step) % *maybeModulus),
+        *maybeModulus,
+    };
+}
+
+// Garner-style incremental combination, std::nullopt when the congruences
+// contradict each other or the combined modulus overflows.
+template<std::ranges::input_range R>
+requires std::convertible_to<std::ranges::range_value_t<R>, Congruence>
+constexpr std::optional<Congruence> crt(R &&congruences)
+{
+    std::optional<Congruence> result = Congruence{};
+    for(const Congruence &congruence : congruences)
+    {
+        result = crt(*result, congruence);
+        if(!result)
+        {
+            break;
+        }
+    }
+    return result;
+}
+
+// Baby-step giant-step: the smallest exp with base^exp == target (mod mod),
+// base must be invertible modulo mod.
+inline std::optional<umax> discreteLog(const umax base, const umax target,
+                                       const umax mod)
+{
+    if(mod == 1)
+    {
+        return 0;
+    }
+    const auto maybeInverse = modInverse(base, mod);
+    if(!maybeInverse)
+    {
+        return std::nullopt;
+    }
+    const auto steps =
+        static_cast<umax>(std::ceil(std::sqrt(static_cast<double>(mod))));
+    std::unordered_map<umax, umax> babySteps;
+    babySteps.reserve(steps);
+    umax cur = 1;
+    for(umax j = 0; j < steps; ++j)
+    {
+        babySteps.emplace(cur, j);
+        cur = mulmod(cur, base, mod);
+    }
+    const auto giantStep = powmod(*maybeInverse, steps, mod);
+    cur = target % mod;
+    for(umax i = 0; i < steps; ++i)
+    {
+        if(const auto iter = babySteps.find(cur); iter != end(babySteps))
+        {
+            return i * steps + iter->second;
+        }
+        cur = mulmod(cur, giantStep, mod);
+    }
+    return std::nullopt;
+}
+
+// Decimal digits of a 128-bit value, which the standard streams can't print.
+inline std::string toDecimal(unsigned __int128 value)
+{
+    std::string result;
+    do
+    {
+        result.push_back(static_cast<char>('0' + value % 10));
+        value /= 10;
+    } while(value != 0);
+    std::ranges::reverse(result);
+    return result;
+}
+}
+
+#endif
@@ -0,0 +1,117 @@
+#ifndef XUTIL_MAPPEDINPUT_HPP
+#define XUTIL_MAPPEDINPUT_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace xutil
+{
+// Whole contents of a file descriptor: mapped when it refers to a regular
+// file, read into memory otherwise (pipes, terminals).
+class MappedInput
+{
+public:
+    explicit MappedInput(const int fd = STDIN_FILENO)
+    {
+        struct stat info{};
+        if(fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0)
+        {
+            const auto size = static_cast<std::size_t>(info.st_size);
+            if(void *addr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+               addr != MAP_FAILED)
+            {
+                madvise(addr, size, MADV_SEQUENTIAL);
+                mapped = static_cast<const char *>(addr);
+                mappedSize = size;
+                return;
+            }
+        }
+        char chunk[1 << 16];
+        ssize_t count = 0;
+        while((count = ::read(fd, chunk, sizeof(chunk))) > 0)
+        {
+            buffer.append(chunk, static_cast<std::size_t>(count));
+        }
+    }
+
+    MappedInput(const MappedInput &) = delete;
+    MappedInput &operator=(const MappedInput &) = delete;
+
+    ~MappedInput()
+    {
+        if(mapped != nullptr)
+        {
+            munmap(const_cast<char *>(mapped), mappedSize);
+        }
+    }
+
+    [[nodiscard]] std::string_view view() const
+    {
+        if(mapped != nullptr)
+        {
+            return {mapped, mappedSize};
+        }
+        return buffer;
+    }
+
+private:
+    const char *mapped{};
+    std::size_t mappedSize{};
+    std::string buffer;
+};
+
+// Splits `text` into at most `count` consecutive chunks ending right after a
+// `separator`, so that no record is cut in two.
+inline std::vector<std::string_view> splitChunks(const std::string_view text,
+                                                 const std::size_t count,
+                                                 const char separator = '\n')
+{
+    std::vector<std::string_view> chunks;
+    std::size_t begin = 0;
+    for(std::size_t i = 1; i <= count && begin < text.size(); ++i)
+    {
+        auto end = std::max(begin, text.size() * i / count);
+        if(i < count)
+        {
+            end = text.find(separator, end);
+            end = (end == std::string_view::npos ? text.size() : end + 1);
+        }
+        else
+        {
+            end = text.size();
+        }
+        chunks.push_back(text.substr(begin, end - begin));
+        begin = end;
+    }
+    return chunks;
+}
+
+// Calls `func(line)` for every non-empty line of `text`.
+template<typename Func>
+void forEachLine(std::string_view text, Func &&func)
+{
+    while(!text.empty())
+    {
+        const auto end = std::min(text.find('\n'), text.size());
+        if(auto line = text.substr(0, end); !line.empty())
+        {
+            if(line.back() == '\r')
+            {
+                line.remove_suffix(1);
+            }
+            func(line);
+        }
+        text.remove_prefix(std::min(end + 1, text.size()));
+    }
+}
+}
+
+#endif
@@ -0,0 +1,109 @@
+#ifndef XUTIL_PARALLEL_HPP
+#define XUTIL_PARALLEL_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <expected>
+#include <functional>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace xutil
+{
+inline std::size_t workerCount()
+{
+    return std::max<std::size_t>(1, std::thread::hardware_concurrency());
+}
+
+namespace detail
+{
+    // At least one worker and no more than there are items.
+    constexpr std::size_t clampWorkers(const std::size_t count,
+                                       const std::size_t workers)
+    {
+        return std::clamp<std::size_t>(workers, 1,
+                                       std::max<std::size_t>(count, 1));
+    }
+}
+
+// Splits [0, count) into contiguous blocks, one per worker, and calls
+// `func(begin, end)` for all of them concurrently.
+template<typename Func>
+void parallelFor(const std::size_t count, Func &&func,
+                 std::size_t workers = workerCount())
+{
+    workers = detail::clampWorkers(count, workers);
+    if(workers == 1)
+    {
+        func(static_cast<std::size_t>(0), count);
+        return;
+    }
+    const auto block = count / workers;
+    const auto remainder = count % workers;
+    std::vector<std::jthread> threads;
+    threads.reserve(workers - 1);
+    std::size_t begin = 0;
+    for(std::size_t i = 0; i + 1 < workers; ++i)
+    {
+        const auto end = begin + block + (i < remainder);
+        threads.emplace_back([&func, begin, end] { func(begin, end); });
+        begin = end;
+    }
+    func(begin, count);
+}
+
+// `map(begin, end)` partial results of the parallelFor blocks folded in
+// order with `reduce`.
+template<typename T, typename Map, typename Reduce = std::plus<>>
+T parallelReduce(const std::size_t count, T init, Map &&map,
+                 Reduce reduce = {}, std::size_t workers = workerCount())
+{
+    workers = detail::clampWorkers(count, workers);
+    std::vector<T> partials(workers, init);
+    parallelFor(
+        workers,
+        [&](const std::size_t firstBlock, const std::size_t lastBlock) {
+            for(auto blockIdx = firstBlock; blockIdx < lastBlock; ++blockIdx)
+            {
+                partials[blockIdx] =
+                    map(count * blockIdx / workers,
+                        count * (blockIdx + 1) / workers);
+            }
+        },
+        workers);
+    for(auto &partial : partials)
+    {
+        init = reduce(std::move(init), std::move(partial));
+    }
+    return init;
+}
+
+// parallelReduce of fallible partial results, `map` returning an
+// std::expected. The values are folded with `reduce` and the first error in
+// block order is returned instead when there is one.
+template<typename T, typename Map, typename Reduce = std::plus<>>
+std::invoke_result_t<Map &, std::size_t, std::size_t> parallelTryReduce(
+    const std::size_t count, T init, Map &&map, Reduce reduce = {},
+    const std::size_t workers = workerCount())
+{
+    using Partial = std::invoke_result_t<Map &, std::size_t, std::size_t>;
+    return parallelReduce(
+        count, Partial{std::move(init)}, map,
+        [&reduce](Partial left, Partial right) -> Partial {
+            if(!left)
+            {
+                return left;
+            }
+            if(!right)
+            {
+                return right;
+            }
+            return reduce(std::move(*left), std::move(*right));
+        },
+        workers);
+}
+}
+
+#endif
@@ -2,11 +2,57 @@
 #define PARSER_PARSESTREAM_HPP
 
 #include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <format>
 #include <optional>
+#include <string>
 #include <string_view>
 
 namespace parser
 {
+enum class ParseErrorCode : std::uint8_t
+{
+    UNEXPECTED_END,
+    UNEXPECTED_CHARACTER,
+    EMPTY_TOKEN,
+    INVALID_VALUE,
+    TRAILING_CHARACTERS,
+};
+
+// Cheap to construct and propagate: the context is expected to be a string
+// literal, the message is only formatted when requested.
+struct ParseError
+{
+    ParseErrorCode code{};
+    std::size_t offset{};
+    const char *context{""};
+
+    [[nodiscard]] std::string message() const
+    {
+        return std::format("{}: {} at offset {}", context, describe(code),
+                           offset);
+    }
+
+    static constexpr std::string_view describe(const ParseErrorCode code)
+    {
+        switch(code)
+        {
+        case ParseErrorCode::UNEXPECTED_END:
+            return "unexpected end of input";
+        case ParseErrorCode::UNEXPECTED_CHARACTER:
+            return "unexpected character";
+        case ParseErrorCode::EMPTY_TOKEN:
+            return "empty token";
+        case ParseErrorCode::INVALID_VALUE:
+            return "invalid value";
+        case ParseErrorCode::TRAILING_CHARACTERS:
+            return "trailing characters";
+        }
+        return "unknown error";
+    }
+};
+
 class ParseStream
 {
 public:
@@ -34,6 +80,17 @@ public:
         return val;
     }
 
+    [[nodiscard]] constexpr std::size_t position() const
+    {
+        return idx;
+    }
+
+    [[nodiscard]] constexpr std::unexpected<ParseError> fail(
+        const ParseErrorCode code, const char *context) const
+    {
+        return std::unexpected(ParseError{code, idx, context});
+    }
+
 private:
     std::size_t idx{};
     std::string_view str;